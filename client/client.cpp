@@ -6,9 +6,30 @@
 #include <unistd.h>
 #include"tucants_game.hpp"
 
-// timeout in milliseconds
+// timeout in milliseconds (the most a decision takes)
 #define TIMEOUT 1000
 
+// whether the decisions manage their time within the timeout (1) or always take all of it (0)
+#define TIME_MANAGEMENT 1
+
+// size of the transposition table in megabytes
+#define TABLE_SIZE 16
+
+// size of the cache of the evaluations in megabytes (0 for none). The evaluation of tucants costs about as
+// much as a hit of the cache and less than a miss, so there is none unless it is asked for.
+#define EVALUATION_CACHE_SIZE 0
+
+// half width of the aspiration window of the search and the factor it is widened by when the score falls outside
+#define ASPIRATION_WINDOW 10
+#define ASPIRATION_WIDENING 2
+
+// number of threads the search runs on, as helpers (Lazy SMP) and by splitting the nodes (Young Brothers Wait)
+#define THREADS 1
+#define SPLIT_THREADS 1
+
+// whether to go on searching while the opponent thinks (1) or not (0)
+#define PONDER 1
+
 /**********************************************************/
 //Position gamePosition;		// Position we are going to use
 tucants_game gamePosition;
@@ -45,12 +66,28 @@ int main( int argc, char ** argv )
 	opterr = 0;
 	unsigned int timeout = TIMEOUT;
 	const char* timeout_string = 0;
-
-	while( ( c = getopt ( argc, argv, "i:p:t:a:h" ) ) != -1 )
+	std::size_t table_size = TABLE_SIZE;
+	const char* table_size_string = 0;
+	std::size_t evaluation_cache_size = EVALUATION_CACHE_SIZE;
+	const char* evaluation_cache_size_string = 0;
+	int aspiration_window = ASPIRATION_WINDOW;
+	const char* aspiration_window_string = 0;
+	double aspiration_widening = ASPIRATION_WIDENING;
+	const char* aspiration_widening_string = 0;
+	unsigned int threads = THREADS;
+	const char* threads_string = 0;
+	unsigned int split_threads = SPLIT_THREADS;
+	const char* split_threads_string = 0;
+	bool ponder = PONDER;
+	const char* ponder_string = 0;
+	bool time_management = TIME_MANAGEMENT;
+	const char* time_management_string = 0;
+
+	while( ( c = getopt ( argc, argv, "i:p:t:a:m:c:w:g:n:y:o:e:h" ) ) != -1 )
 		switch( c )
 		{
 			case 'h':
-				printf( "[-i ip] [-p port]\n" );
+				printf( "[-i ip] [-p port] [-t timeout (ms)] [-a name] [-m table size (MB)] [-c evaluation cache size (MB, 0 for none)] [-w aspiration window (0 for none)] [-g aspiration widening] [-n threads] [-y split threads] [-o ponder (0 or 1)] [-e time management (0 or 1)]\n" );
 				return 0;
 			case 'i':
 				ip = optarg;
@@ -64,6 +101,30 @@ int main( int argc, char ** argv )
 			case 'a':
 				agentName = optarg;
 				break;
+			case 'm':
+				table_size_string = optarg;
+				break;
+			case 'c':
+				evaluation_cache_size_string = optarg;
+				break;
+			case 'w':
+				aspiration_window_string = optarg;
+				break;
+			case 'g':
+				aspiration_widening_string = optarg;
+				break;
+			case 'n':
+				threads_string = optarg;
+				break;
+			case 'y':
+				split_threads_string = optarg;
+				break;
+			case 'o':
+				ponder_string = optarg;
+				break;
+			case 'e':
+				time_management_string = optarg;
+				break;
 			case '?':
 				if( optopt == 'i' || optopt == 'p' )
 					printf( "Option -%c requires an argument.\n", ( char ) optopt );
@@ -84,6 +145,60 @@ int main( int argc, char ** argv )
 		timeout = std::stoi(val);
 	}
 
+	// likewise for the size of the transposition table
+	if (table_size_string != 0){
+		std::string val(table_size_string);
+
+		table_size = std::stoi(val);
+	}
+
+	// and of the evaluation cache
+	if (evaluation_cache_size_string != 0){
+		std::string val(evaluation_cache_size_string);
+
+		evaluation_cache_size = std::stoi(val);
+	}
+
+	// and for the aspiration window
+	if (aspiration_window_string != 0){
+		std::string val(aspiration_window_string);
+
+		aspiration_window = std::stoi(val);
+	}
+
+	if (aspiration_widening_string != 0){
+		std::string val(aspiration_widening_string);
+
+		aspiration_widening = std::stod(val);
+	}
+
+	// and for the number of threads
+	if (threads_string != 0){
+		std::string val(threads_string);
+
+		threads = std::stoi(val);
+	}
+
+	if (split_threads_string != 0){
+		std::string val(split_threads_string);
+
+		split_threads = std::stoi(val);
+	}
+
+	// and for pondering
+	if (ponder_string != 0){
+		std::string val(ponder_string);
+
+		ponder = (std::stoi(val) != 0);
+	}
+
+	// and for the time management
+	if (time_management_string != 0){
+		std::string val(time_management_string);
+
+		time_management = (std::stoi(val) != 0);
+	}
+
 	connectToTarget( port, ip, &mySocket );
 
 	char msg;
@@ -100,6 +215,15 @@ int main( int argc, char ** argv )
 
 	int previous_ants_removed_num = 0;
 
+	// the search is kept for the whole game, so that each decision goes on with what the previous ones
+	// (and the ponder in between) have learned
+	tucants_game_cutoff cutoff;
+	search::iterative_deepening_alpha_beta_expectiminimax<tucants> minimax(cutoff, table_size, evaluation_cache_size);
+	minimax.set_aspiration_window(aspiration_window, aspiration_widening);
+	minimax.set_threads(threads);
+	minimax.set_split_threads(split_threads);
+	minimax.set_time_management(time_management);
+
 	while( 1 )
 	{
 		print_game_information(gamePosition);
@@ -122,8 +246,12 @@ int main( int argc, char ** argv )
 					std::cout << "Reset received. Starting anew!" << std::endl;
 					gamePosition.init();
 					previous_ants_removed_num = 0;
+					minimax.new_game();
 				}
 				else if (gamePosition.pos.turn == myColor){
+					// the opponent has moved, the ponder is over. Whether it hit is found out by the decision
+					minimax.stop_pondering();
+
 					// this is the board after the move the opponent has made
 					// we must update the count of the number of ants the opponent has captured from me
 					int next_ants_removed_num = ants_removed(gamePosition.pos, myColor);
@@ -158,20 +286,34 @@ int main( int argc, char ** argv )
 				{
 					// here is where we run expectiminimax on the current position
 					// and it is our move the algorithm returns which action to do
-					tucants_game_cutoff cutoff;
-					search::iterative_deepening_alpha_beta_expectiminimax<tucants> minimax(cutoff);
-
 					myMove = minimax.decision(gamePosition, timeout);
+
+					if (ponder){
+						std::cout << (minimax.ponder_hit() ? "Ponder hit" : "Ponder miss") << std::endl;
+					}
+
+					search::evaluation_cache_statistics evaluations = minimax.evaluation_statistics();
+
+					if (evaluations.probes != 0){
+						std::cout << "Evaluation cache hits: " << 100.0*evaluations.hit_rate() << "% of " << evaluations.probes << " probes" << std::endl;
+					}
 				}
 
 				// count how many we will capture
 				gamePosition.player_num_ants_captured += num_captured_ants(myMove);
 				assert(myMove.color == gamePosition.player);
 				sendMove( &myMove, mySocket );			//send our move
+
+				// think about the next move while the opponent thinks about its own (the search only knows
+				// what to expect after a move it has decided, not after the null move)
+				if (ponder && myMove.tile[ 0 ][ 0 ] != -1){
+					minimax.start_pondering();
+				}
 				
 				break;
 
 			case NM_QUIT:			//server wants us to quit...we shall obey
+				minimax.stop_pondering();
 				close( mySocket );
 				return 0;
 		}
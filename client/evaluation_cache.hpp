@@ -0,0 +1,144 @@
+/*
+ * evaluation_cache.hpp
+ *
+ *  Created on: Jun 6, 2013
+ *      Author: croatoan
+ */
+
+#ifndef EVALUATION_CACHE_HPP_
+#define EVALUATION_CACHE_HPP_
+
+#include<atomic>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<type_traits>
+
+namespace search{
+
+// The counts of the probes of an evaluation cache and of the ones that found the state, for sizing the cache
+struct evaluation_cache_statistics{
+	std::uint64_t probes;
+	std::uint64_t hits;
+
+	evaluation_cache_statistics() : probes(0), hits(0){}
+
+	evaluation_cache_statistics& operator+=(const evaluation_cache_statistics& other){
+		probes += other.probes;
+		hits += other.hits;
+		return *this;
+	}
+
+	double hit_rate() const{
+		return probes == 0 ? 0.0 : static_cast<double>(hits)/probes;
+	}
+};
+
+/**
+ * A fixed size cache of the values of the evaluation function keyed by the hash of the states. The same leaves
+ * are evaluated over and over (by each iteration of the iterative deepening, and again when the search of a
+ * node is repeated with another window), and a probe of the cache is cheaper than an evaluation that is
+ * more than a few terms. It is kept apart from the transposition table, whose slots are taken by the searched
+ * nodes and are much bigger.
+ *
+ * The cache is direct mapped: each key maps to exactly one slot (the low bits of the key) and a new value
+ * always replaces the one in its slot. Like the transposition table it can be shared by threads without any
+ * locking: the slot keeps the key XORed with the words of the value, so a slot whose words were written by two
+ * threads at once (or read while being written) doesn't verify against the key and is taken as a miss. An
+ * empty slot reads as the state with key zero, a collision as unlikely as any other.
+ *
+ * Utility : the type of the values cached, which must be trivially copyable
+ */
+template<class Utility>
+class evaluation_cache{
+public:
+	static_assert(std::is_trivially_copyable<Utility>::value, "evaluation_cache: the utility values must be trivially copyable");
+
+	// constructs a cache taking up (at most) the given number of megabytes. The number of slots is always a
+	// power of two so that the slot of a key can be found with a mask.
+	explicit evaluation_cache(std::size_t megabytes){
+		std::size_t bytes = megabytes*1024*1024;
+		std::size_t num_entries = 1;
+
+		while (num_entries*2*sizeof(slot) <= bytes){
+			num_entries *= 2;
+		}
+
+		table.reset(new slot[num_entries]);
+		num_slots = num_entries;
+		mask = num_entries - 1;
+		clear();
+	}
+
+	evaluation_cache(const evaluation_cache&) = delete;
+	evaluation_cache& operator=(const evaluation_cache&) = delete;
+
+	// Looks up the state with the given key. Returns true and fills in value if the state is found.
+	bool probe(std::uint64_t key, Utility& value) const{
+		const slot& s = table[key & mask];
+		std::uint64_t words[num_words];
+		std::uint64_t check = s.check.load(std::memory_order_relaxed);
+
+		for (std::size_t i = 0; i < num_words; ++i){
+			words[i] = s.data[i].load(std::memory_order_relaxed);
+			check ^= words[i];
+		}
+
+		if (check != key){
+			return false;
+		}
+
+		std::memcpy(&value, words, sizeof(Utility));
+
+		return true;
+	}
+
+	// Stores the value of the state with the given key
+	void store(std::uint64_t key, const Utility& value){
+		slot& s = table[key & mask];
+		std::uint64_t words[num_words];
+
+		std::memset(words, 0, sizeof(words));
+		std::memcpy(words, &value, sizeof(Utility));
+
+		std::uint64_t check = key;
+
+		for (std::size_t i = 0; i < num_words; ++i){
+			s.data[i].store(words[i], std::memory_order_relaxed);
+			check ^= words[i];
+		}
+		s.check.store(check, std::memory_order_relaxed);
+	}
+
+	// empties the cache (it must not be in use by any search)
+	void clear(){
+		for (std::size_t i = 0; i < num_slots; ++i){
+			for (std::size_t j = 0; j < num_words; ++j){
+				table[i].data[j].store(0, std::memory_order_relaxed);
+			}
+			table[i].check.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// the number of slots of the cache
+	std::size_t size() const{
+		return num_slots;
+	}
+private:
+	// the number of words a value is packed in
+	static const std::size_t num_words = (sizeof(Utility) + sizeof(std::uint64_t) - 1)/sizeof(std::uint64_t);
+
+	struct slot{
+		std::atomic<std::uint64_t> check; // the key XORed with the words of data
+		std::atomic<std::uint64_t> data[num_words];
+	};
+
+	std::unique_ptr<slot[]> table;
+	std::size_t num_slots;
+	std::size_t mask;
+};
+
+} // namespace search
+
+#endif /* EVALUATION_CACHE_HPP_ */
@@ -0,0 +1,103 @@
+/*
+ * fixed_vector.hpp
+ *
+ *  Created on: May 27, 2013
+ *      Author: croatoan
+ */
+
+#ifndef FIXED_VECTOR_HPP_
+#define FIXED_VECTOR_HPP_
+
+#include<cassert>
+#include<cstddef>
+
+namespace search{
+
+/**
+ * A vector with a fixed capacity whose elements live inside the object itself, so that it never allocates.
+ * It is meant to be used as a local variable for the actions of a node of the search, with a capacity equal to
+ * the maximum branching factor of the game. Pushing to a full vector is an error (it is ignored in release
+ * builds).
+ *
+ * It provides as much of the interface of std::vector as the search needs, including what std::back_inserter()
+ * needs, so the move generators can write into it directly.
+ */
+template<class T, std::size_t N>
+class fixed_vector{
+public:
+	typedef T value_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef std::size_t size_type;
+
+	fixed_vector() : num_elements(0){}
+
+	void push_back(const T& value){
+		assert(num_elements < N && "fixed_vector::push_back(): the vector is full");
+
+		if (num_elements < N){
+			elements[num_elements++] = value;
+		}
+	}
+
+	void pop_back(){
+		--num_elements;
+	}
+
+	void clear(){
+		num_elements = 0;
+	}
+
+	size_type size() const{
+		return num_elements;
+	}
+
+	bool empty() const{
+		return num_elements == 0;
+	}
+
+	bool full() const{
+		return num_elements == N;
+	}
+
+	static size_type capacity(){
+		return N;
+	}
+
+	reference operator[](size_type i){
+		return elements[i];
+	}
+
+	const_reference operator[](size_type i) const{
+		return elements[i];
+	}
+
+	reference back(){
+		return elements[num_elements - 1];
+	}
+
+	iterator begin(){
+		return elements;
+	}
+
+	iterator end(){
+		return elements + num_elements;
+	}
+
+	const_iterator begin() const{
+		return elements;
+	}
+
+	const_iterator end() const{
+		return elements + num_elements;
+	}
+private:
+	T elements[N];
+	size_type num_elements;
+};
+
+} // namespace search
+
+#endif /* FIXED_VECTOR_HPP_ */
@@ -13,8 +13,21 @@
 #include<utility>
 #include<tuple>
 #include<stack>
+#include<vector>
 #include<limits>
+#include<cstdint>
+#include<algorithm>
+#include<cmath>
+#include<memory>
+#include<atomic>
+#include<thread>
+#include<mutex>
 #include"time_limit_cutoff_test.hpp"
+#include"transposition_table.hpp"
+#include"evaluation_cache.hpp"
+#include"monotonic_arena.hpp"
+#include"work_stealing_pool.hpp"
+#include"time_manager.hpp"
 
 namespace search{
 
@@ -28,15 +41,41 @@ namespace search{
  * UtilityType : type of the utility value
  * SuccessorsFunction : a functor object that must provide the following signature with the purpose
  * of returning all the actions, as well as the states they lead to, from the input state.
- * 					std::list<std::tuple<Action,State,double> > operator()(const State&)
- * where the third item in the tuple is the probability for that action in case that the input State is a chance node.
+ * 					SuccessorsList operator()(const State&)
+ * where SuccessorsList is a std::list<std::tuple<Action,State,double> > and the third item in the tuple is the
+ * probability for that action in case that the input State is a chance node. The list may use any allocator; with
+ * an arena_allocator its nodes come from the arena of the search (see below) and cost next to nothing to
+ * allocate and release.
  * EvaluationFunction: a functor object that must provide the following signature:
  * 					utility_type operator()(const State&)
  * CutoffTest : the cutoff test for the search. This can be a non-pure functor object (that is the copy
  * received at the constructor of the search is preserved). The signature to be provided is:
  * 			bool operator()(const State&)
  * ActionOrdering : whose aim is to order the actions returned from the successorsfunction. It must
- * provide the following signature: void operator()(std::list<std::tuple<Action,State,double> >&)
+ * provide the following signature: void operator()(SuccessorsList&)
+ * Hashing : the game must provide a static function std::uint64_t hash(const State&) that returns a (Zobrist)
+ * hash key of the state. It is used to index the transposition table. Actions must be comparable with ==.
+ * The game must also provide a static function void prepare(State&) that is called on the root state of
+ * each search so that any data the game maintains incrementally along the moves (such as the hash key)
+ * can be computed from scratch.
+ * Quiescence : the game must provide a static function bool quiet(const State&) that tells whether a max or
+ * min node is quiet, that is whether its value can be told by the evaluation function. The search doesn't stop
+ * at the depth limit on a node that isn't quiet but goes on until it reaches quiet nodes. The actions of a node
+ * that isn't quiet must be few and must lead to quiet nodes before long (such as the captures, when capturing
+ * is mandatory) since all of them are searched.
+ * Lazy evaluation : the game must provide a static function void evaluation_bounds(const State&, UtilityType&
+ * lower, UtilityType& upper) that bounds the value of the evaluation function at a quiet node cheaply (such as
+ * with the terms of the evaluation that cost next to nothing and margins for the rest). The bounds need not be
+ * strict, only hold for all but a few nodes. The search evaluates a quiet node at the depth limit only if the
+ * bounds overlap the window it is searched with, otherwise the bound beyond the window is its value.
+ * Move ordering : the actions of the max and min nodes are ordered by the heuristics of the search (see
+ * action_heuristics). For them the game must provide a static function int action_priority(const Action&) that
+ * ranks the actions that must go first whatever the heuristics say (such as the captures) with a value above
+ * zero and the rest with zero, and a static function std::size_t history_key(const Action&) that tells
+ * the actions apart for the history of the search (such as by their from and to cells), along with the number of
+ * the keys as the static member num_history_keys.
+ * SearchMode : one of the tags successor_list_mode or make_unmake_mode (see below). It selects whether the
+ * search works on the lists of the SuccessorsFunction or applies and undoes the actions on a single state.
  */
 template<class Game>
 struct game_traits{
@@ -47,6 +86,7 @@ struct game_traits{
 	typedef typename Game::evaluation_function_type evaluation_function_type;
 	typedef typename Game::cutoff_test_type cutoff_test_type;
 	typedef typename Game::action_ordering_type action_ordering_type;
+	typedef typename Game::successors_list_type successors_list_type;
 
 	// Returns the minus infinity for the range of values representable by the utility type
 	static utility_type min_utility_value(){
@@ -80,12 +120,436 @@ struct game_traits{
 	static std::tuple<bool, utility_type, utility_type> bounded(){
 		return Game::bounded();
 	}
+
+	// Returns the hash key of the state. Two states that are equal must have the same key.
+	static std::uint64_t hash(const state_type& state){
+		return Game::hash(state);
+	}
+
+	// Computes from scratch any incrementally maintained data of the root state of a search
+	static void prepare(state_type& state){
+		Game::prepare(state);
+	}
+
+	// Returns whether the evaluation function can tell the value of the (max or min node) state
+	static bool quiet(const state_type& state){
+		return Game::quiet(state);
+	}
+
+	// Bounds cheaply the value of the evaluation function at the quiet state
+	static void evaluation_bounds(const state_type& state, utility_type& lower, utility_type& upper){
+		Game::evaluation_bounds(state, lower, upper);
+	}
+
+	// Returns the priority of the action in the ordering of the actions of a node (zero for most actions)
+	static int action_priority(const action_type& action){
+		return Game::action_priority(action);
+	}
+
+	// the number of keys of the history table and the key of an action in it
+	static const std::size_t num_history_keys = Game::num_history_keys;
+
+	static std::size_t history_key(const action_type& action){
+		return Game::history_key(action);
+	}
 };
 
 // For the expectiminimax algorithm each node can be one of three types:
 // Max Node, Min Node or Chance Node
 enum class StateNodeType  {MAX_NODE, MIN_NODE, CHANCE_NODE};
 
+/**
+ * The heuristics the actions of the max and min nodes are ordered with (after the action of the principal
+ * variation or the best action of the transposition table, which are searched first). The actions are ranked:
+ * 		first by the priority the game gives them (the longer capture chains first in tucants),
+ * 		then the killer actions of the ply of the node: the last two actions that caused a cutoff at a node of
+ * 		that ply and have no priority. A move that refutes one move often refutes its siblings as well.
+ * 		then by the history table: the squares of the depths of all the cutoffs caused by the action (as told
+ * 		apart by its history key), so that the actions that cut off big subtrees go first.
+ * None of them needs the children to be evaluated. Each search keeps its own heuristics, they aren't shared
+ * by threads.
+ */
+template<class Game>
+class action_heuristics{
+public:
+	typedef game_traits<Game> gtraits;
+	typedef typename gtraits::action_type action_type;
+
+	action_heuristics() : history(gtraits::num_history_keys, 0){}
+
+	// Records that the action caused a cutoff at a node of the given ply searched with the given depth
+	void cutoff(const action_type& action, std::size_t ply, int depth){
+		if (gtraits::action_priority(action) == 0){
+			if (ply >= killers.size()){
+				killers.resize(ply + 1);
+			}
+
+			killer_pair& killer = killers[ply];
+
+			if (!(killer.count > 0 && killer.action[0] == action)){
+				killer.action[1] = killer.action[0];
+				killer.action[0] = action;
+				killer.count = std::min(killer.count + 1, 2);
+			}
+		}
+
+		// the nodes past the depth limit count as depth 1
+		int& value = history[gtraits::history_key(action)];
+
+		value += depth > 0 ? depth*depth : 1;
+
+		if (value > max_history){
+			age();
+		}
+	}
+
+	// The score of the action at a node of the given ply. The actions with greater scores are searched first.
+	int score(const action_type& action, std::size_t ply) const{
+		int priority = gtraits::action_priority(action);
+
+		if (priority == 0 && ply < killers.size()){
+			const killer_pair& killer = killers[ply];
+
+			for (int i = 0; i < killer.count; ++i){
+				if (killer.action[i] == action){
+					return (2 - i)*killer_weight + history[gtraits::history_key(action)];
+				}
+			}
+		}
+
+		return priority*priority_weight + history[gtraits::history_key(action)];
+	}
+
+	// Starts a new search: the killers are forgotten (they are tied to the plies of the last search) and the
+	// history fades
+	void new_search(){
+		killers.clear();
+		age();
+	}
+
+	// forgets everything
+	void clear(){
+		killers.clear();
+		std::fill(history.begin(), history.end(), 0);
+	}
+private:
+	// the killers are ranked above any history value and the priorities above the killers
+	static const int max_history = (1 << 20) - 1;
+	static const int killer_weight = 1 << 21;
+	static const int priority_weight = 1 << 23;
+
+	struct killer_pair{
+		killer_pair() : count(0){}
+
+		action_type action[2]; // the latest first
+		int count;
+	};
+
+	// halves the history table
+	void age(){
+		for (std::size_t i = 0; i < history.size(); ++i){
+			history[i] /= 2;
+		}
+	}
+
+	std::vector<killer_pair> killers; // the killers of each ply
+	std::vector<int> history;
+};
+
+// The search walks the children of a state in one of the following modes, as selected by the
+// search_mode_type of the game.
+//
+// successor_list_mode : the children are taken from the list returned by the SuccessorsFunction (each one
+// a copy of the state) and they are ordered by the ActionOrdering (and by the heuristics, if given).
+//
+// make_unmake_mode : the search keeps a single mutable state and each child is reached by applying an action
+// to it and left by undoing that action. The game must provide the following (static functions):
+// 		undo_type : the record needed to undo an action or an outcome
+// 		action_list_type : a container of actions (with size(), operator[], begin() and end())
+// 		outcome_type, outcome_list_type : the outcomes of a chance node. The container holds pairs of
+// 					an outcome and its probability.
+// 		num_action_stages : (a static member) the number of the stages the actions of a max or min node are
+// 					generated in
+// 		void actions(const State&, int stage, action_list_type&) : the actions of a max or min node generated
+// 					at the given stage, in the order they are searched unless there are heuristics to order
+// 					them. The stages together must generate every action of the node, each one once, and the
+// 					earlier stages should generate the actions more likely to cause a cutoff (such as the
+// 					captures). A stage is only generated once the actions of the stages before it are searched
+// 					without a cutoff.
+// 		bool legal(const State&, const Action&) : whether the action is an action of the max or min node. It is
+// 					used to search the first actions (such as the best action of the transposition table,
+// 					which may be left from another state) before any stage is generated.
+// 		void outcomes(const State&, outcome_list_type&) : the outcomes of a chance node
+// 		void apply(State&, const Action&, undo_type&) : applies an action, filling in the undo record
+// 		void apply_outcome(State&, const outcome_type&, undo_type&) : applies an outcome of a chance node
+// 		void undo(State&, const undo_type&) : undoes an action or an outcome
+struct successor_list_mode{};
+struct make_unmake_mode{};
+
+// A successor_generator walks the children of a state one at a time:
+// 		while (children.next()){ ... children.state() ... }
+// next() moves to the next child and returns false when there are no more. state() is the current child,
+// action() the action leading to it (not meaningful for the children of a chance node) and probability()
+// its probability (only meaningful for the children of a chance node). If first is not null it points to
+// num_first actions that are walked first, in the given order (those that are not actions of the state are
+// skipped), and then the rest of the actions in the order of the heuristics for the given ply (if they are not
+// null) or else in the order of the game. size() is the number of children and probability(i) the
+// probability of the i-th one, both known before any child is walked, for chance nodes (the actions of the
+// other nodes may be generated lazily, see make_unmake_mode).
+template<class Game, class Mode = typename Game::search_mode_type>
+class successor_generator;
+
+template<class Game>
+class successor_generator<Game, successor_list_mode>{
+public:
+	typedef game_traits<Game> gtraits;
+
+	typedef typename gtraits::state_type state_type;
+	typedef typename gtraits::action_type action_type;
+	typedef typename gtraits::successors_function_type successors_function_type;
+	typedef typename gtraits::action_ordering_type action_ordering_type;
+	typedef typename gtraits::successors_list_type successors_list;
+	typedef action_heuristics<Game> heuristics_type;
+
+	successor_generator(state_type& state, successors_function_type& successors, action_ordering_type& action_order, const action_type* first, std::size_t num_first = 1, const heuristics_type* heuristics = 0, std::size_t ply = 0) : children(std::move(successors(state))), started(false){
+		// Apply action ordering optimization
+		if (state.node_type() != StateNodeType::CHANCE_NODE){
+			action_order(children);
+
+			// the heuristics break the ties of the order of the game
+			if (heuristics != 0){
+				children.sort([heuristics, ply](const typename successors_list::value_type& x, const typename successors_list::value_type& y) -> bool{
+					return heuristics->score(std::get<0>(x), ply) > heuristics->score(std::get<0>(y), ply);
+				});
+			}
+		}
+
+		// and move the first actions to the front (the last of them first so that they end up in order)
+		for (std::size_t i = (first != 0 ? num_first : 0); i > 0; --i){
+			for (typename successors_list::iterator it = children.begin(), last = children.end(); it != last; ++it){
+				if (std::get<0>(*it) == first[i - 1]){
+					children.splice(children.begin(), children, it);
+					break;
+				}
+			}
+		}
+
+		current = children.begin();
+	}
+
+	successor_generator(const successor_generator&) = delete;
+	successor_generator& operator=(const successor_generator&) = delete;
+
+	bool next(){
+		if (started){
+			++current;
+		}
+		started = true;
+
+		return current != children.end();
+	}
+
+	state_type& state(){
+		return std::get<1>(*current);
+	}
+
+	const action_type& action() const{
+		return std::get<0>(*current);
+	}
+
+	double probability() const{
+		return std::get<2>(*current);
+	}
+
+	std::size_t size() const{
+		return children.size();
+	}
+
+	double probability(std::size_t i) const{
+		typename successors_list::const_iterator it = children.begin();
+		std::advance(it, i);
+		return std::get<2>(*it);
+	}
+private:
+	successors_list children;
+	typename successors_list::iterator current;
+	bool started;
+};
+
+template<class Game>
+class successor_generator<Game, make_unmake_mode>{
+public:
+	typedef game_traits<Game> gtraits;
+
+	typedef typename gtraits::state_type state_type;
+	typedef typename gtraits::action_type action_type;
+	typedef typename gtraits::successors_function_type successors_function_type;
+	typedef typename gtraits::action_ordering_type action_ordering_type;
+
+	typedef typename Game::undo_type undo_type;
+	typedef typename Game::action_list_type action_list_type;
+	typedef typename Game::outcome_list_type outcome_list_type;
+	typedef action_heuristics<Game> heuristics_type;
+
+	// the most actions of a node the heuristics order (the rest are left in the order of the game)
+	static const std::size_t max_ordered_actions = 256;
+
+	// The actions of a max or min node are produced in stages as they are needed: the first actions (checked
+	// with Game::legal()) and then each stage of the game in turn, ordered by the heuristics. A node that cuts
+	// off after its first actions never generates any other.
+	successor_generator(state_type& state, successors_function_type&, action_ordering_type&, const action_type* _first, std::size_t _num_first = 1, const heuristics_type* _heuristics = 0, std::size_t _ply = 0) : parent(state), chance(state.node_type() == StateNodeType::CHANCE_NODE), first(_first), num_first(_first != 0 ? _num_first : 0), num_walked_first(0), heuristics(_heuristics), ply(_ply), stage(-1), index(0), count(0), made(false){
+		if (chance){
+			Game::outcomes(parent, outcomes);
+			count = outcomes.size();
+		}
+	}
+
+	successor_generator(const successor_generator&) = delete;
+	successor_generator& operator=(const successor_generator&) = delete;
+
+	// the parent state is left as it was found
+	~successor_generator(){
+		if (made){
+			Game::undo(parent, undo);
+		}
+	}
+
+	bool next(){
+		if (made){
+			Game::undo(parent, undo);
+			made = false;
+		}
+
+		if (chance){
+			if (index == count){
+				return false;
+			}
+
+			Game::apply_outcome(parent, outcomes[index].first, undo);
+			made = true;
+			++index;
+
+			return true;
+		}
+
+		if (!next_action()){
+			return false;
+		}
+
+		Game::apply(parent, current, undo);
+		made = true;
+
+		return true;
+	}
+
+	state_type& state(){
+		return parent;
+	}
+
+	const action_type& action() const{
+		return current;
+	}
+
+	double probability() const{
+		return chance ? outcomes[index - 1].second : 0.0;
+	}
+
+	std::size_t size() const{
+		return count;
+	}
+
+	double probability(std::size_t i) const{
+		return chance ? outcomes[i].second : 0.0;
+	}
+private:
+	// Sets current to the next action of a max or min node, generating the next stages as needed. Returns
+	// false when there are no more actions.
+	bool next_action(){
+		// the first actions (each legal one once)
+		while (stage < 0 && num_walked_first < num_first){
+			const action_type& action = first[num_walked_first++];
+
+			if (!walked(action) && Game::legal(parent, action)){
+				walked_first.push_back(action);
+				current = action;
+				return true;
+			}
+		}
+
+		for (;;){
+			while (index < actions.size()){
+				const action_type& action = actions[index++];
+
+				if (!walked(action)){
+					current = action;
+					return true;
+				}
+			}
+
+			if (stage + 1 >= Game::num_action_stages){
+				return false;
+			}
+
+			++stage;
+			actions.clear();
+			index = 0;
+			Game::actions(parent, stage, actions);
+
+			if (heuristics != 0){
+				order();
+			}
+		}
+	}
+
+	// Whether the action is one of the first actions walked already
+	bool walked(const action_type& action) const{
+		for (std::size_t i = 0; i < walked_first.size(); ++i){
+			if (walked_first[i] == action){
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Sorts the actions by their scores, the greatest first. The lists are short, so a (stable) insertion sort
+	// will do.
+	void order(){
+		int scores[max_ordered_actions];
+		std::size_t n = std::min(actions.size(), max_ordered_actions);
+
+		for (std::size_t i = 0; i < n; ++i){
+			int score = heuristics->score(actions[i], ply);
+			action_type action = actions[i];
+			std::size_t j = i;
+
+			for (; j > 0 && scores[j - 1] < score; --j){
+				scores[j] = scores[j - 1];
+				actions[j] = actions[j - 1];
+			}
+
+			scores[j] = score;
+			actions[j] = action;
+		}
+	}
+
+	state_type& parent;
+	bool chance;
+	const action_type* first;
+	std::size_t num_first;
+	std::size_t num_walked_first; // the number of the first actions looked at
+	action_list_type walked_first; // the first actions that were walked
+	const heuristics_type* heuristics;
+	std::size_t ply;
+	int stage; // the stage the actions are taken from (-1 for the first actions)
+	action_list_type actions; // the actions of the stage
+	outcome_list_type outcomes;
+	std::size_t index;
+	std::size_t count;
+	action_type current;
+	bool made;
+	undo_type undo;
+};
+
 // The class that implements the expectiminimax algorithm with alpha-beta pruning.
 // Specifically, it supports the following:
 // 		1) Chance nodes
@@ -94,95 +558,1140 @@ enum class StateNodeType  {MAX_NODE, MIN_NODE, CHANCE_NODE};
 //		4) Cutoff Test
 //		5) Evaluation Function
 //		6) Iterative Deepening with Timeout Cutoff
+//		7) Transposition Table
+//		8) Star1/Star2 pruning at the chance nodes (if the utility values are bounded)
+//		9) Principal variation search and aspiration windows at the root
+//		10) Root move ordering and principal variation carried over the iterations
+//		11) Lazy SMP: helper threads searching along with the decision, sharing the transposition table
+//		12) Young Brothers Wait: the children of a node after the first one searched in parallel
+//		13) Pondering: searching the expected position on the opponent's time
+//		14) A context kept across the decisions of a game: the transposition table (whose entries age with each
+//			search) and the principal variation expected to go on at the next decision
+//		15) Quiescence search: the nodes at the depth limit that aren't quiet are searched further
+//		16) Killer and history heuristics for the action ordering
+//		17) Time management: the time of a decision is a ceiling, within which the iterations that would not
+//			finish are not started and the settled positions are decided sooner than the volatile ones
+//		18) Lazy evaluation: the leaves whose cheap bounds lie outside the window aren't evaluated in full
+//		19) Evaluation cache: the values of the leaves evaluated in full are kept in a cache of their own,
+//			shared by all the threads like the transposition table
+//
+// Each decision owns a monotonic arena from which the containers of the search (if their allocator is an
+// arena_allocator) take their memory. All of it is released at once when the decision returns.
 template<class Game>
 class iterative_deepening_alpha_beta_expectiminimax{
 public:
 	typedef game_traits<Game> gtraits;
 
-	typedef typename gtraits::state_type state_type;
-	typedef typename gtraits::action_type action_type;
-	typedef typename gtraits::utility_type utility_type;
-	typedef typename gtraits::successors_function_type successors_function_type;
-	typedef typename gtraits::evaluation_function_type evaluation_function_type;
-	typedef typename gtraits::cutoff_test_type cutoff_test_type;
-	typedef typename gtraits::action_ordering_type action_ordering_type;
+	typedef typename gtraits::state_type state_type;
+	typedef typename gtraits::action_type action_type;
+	typedef typename gtraits::utility_type utility_type;
+	typedef typename gtraits::successors_function_type successors_function_type;
+	typedef typename gtraits::evaluation_function_type evaluation_function_type;
+	typedef typename gtraits::cutoff_test_type cutoff_test_type;
+	typedef typename gtraits::action_ordering_type action_ordering_type;
+
+	typedef transposition_table<action_type, utility_type> transposition_table_type;
+	typedef typename transposition_table_type::entry transposition_entry;
+	typedef evaluation_cache<utility_type> evaluation_cache_type;
+	typedef successor_generator<Game> successor_generator_type;
+	typedef action_heuristics<Game> heuristics_type;
+
+	// the default size of the transposition table in megabytes
+	static const std::size_t default_table_size = 16;
+
+	// the default size of the evaluation cache in megabytes. There is none by default: a probe costs a read of
+	// memory, which only pays off for an evaluation function that costs more than that.
+	static const std::size_t default_evaluation_cache_size = 0;
+
+	// the most outcomes of a chance node searched with the Star1/Star2 pruning (nodes with more outcomes are
+	// searched without it)
+	static const std::size_t max_chance_outcomes = 16;
+
+	// the default least depth of the nodes whose children are searched in parallel (see set_split_threads())
+	static const int default_min_split_depth = 3;
+
+	// constructor. An evaluation cache of size zero means no cache at all.
+	iterative_deepening_alpha_beta_expectiminimax(const cutoff_test_type& _cutoff = cutoff_test_type(), std::size_t table_size = default_table_size, std::size_t evaluation_cache_size = default_evaluation_cache_size) : cutoff(_cutoff), table(std::make_shared<transposition_table_type>(table_size)), evaluations(evaluation_cache_size != 0 ? std::make_shared<evaluation_cache_type>(evaluation_cache_size) : nullptr), aspiration_window(), aspiration_widening(2), root_depth(0), following_pv(false), has_partial_action(false), helper_id(0), split_pool(0), split_index(0), min_split_depth(default_min_split_depth), ponder_stop(false), has_ponder_result(false), last_ponder_hit(false), has_expected_root(false){}
+
+	// a search that is pondering stops before it is destroyed
+	~iterative_deepening_alpha_beta_expectiminimax(){
+		stop_pondering();
+	}
+
+	iterative_deepening_alpha_beta_expectiminimax(const iterative_deepening_alpha_beta_expectiminimax&) = delete;
+	iterative_deepening_alpha_beta_expectiminimax& operator=(const iterative_deepening_alpha_beta_expectiminimax&) = delete;
+
+	// It returns the action to take as a result of the expectiminimax algorithm on the input state, in at most
+	// msec milliseconds (see set_time_management() for how much of them it takes).
+	//
+	// The search is meant to be kept for all the decisions of a game: what it learns at one decision (its
+	// transposition table and its principal variation) is carried to the next one, and it must be reset with
+	// new_game() before another game starts.
+	action_type decision(const state_type& root, unsigned int msec){
+		timeout_cutoff timeout(msec);
+
+		stop_pondering();
+
+		state_type state = root;
+		gtraits::prepare(state);
+		std::stack<action_type> actions;
+
+		// the value of the root found by the previous iteration
+		utility_type score = utility_type();
+		int depth = 0;
+
+		// if the root is the position that was pondered, the search goes on from the iteration the ponder was
+		// interrupted at, with its root order, principal variation and score (and its results in the
+		// transposition table). Otherwise it is a new search of the table, which starts from the rest of the
+		// principal variation of the last decision if the game went on along it. Each iteration starts from
+		// the root order and the principal variation of the previous one.
+		std::uint64_t key = gtraits::hash(state);
+
+		last_ponder_hit = has_ponder_result && key == ponder_key;
+
+		if (last_ponder_hit){
+			depth = ponder_depth;
+			score = ponder_score;
+			actions.push(ponder_action);
+		}
+		else{
+			table->new_search();
+			new_search_heuristics();
+			start_principal_variation(has_expected_root && key == gtraits::hash(expected_root));
+		}
+		has_ponder_result = false;
+		reset_evaluation_statistics();
+
+		arena_scope scope(arena);
+		helper_threads running_helpers(*this, root, msec);
+		split_pool_activation activation(split_pool);
+
+		timing.start(msec);
+
+		action_type action = deepen(state, depth, timeout, actions, score, &timing);
+
+		expect_next_root(state, action);
+
+		return action;
+	}
+
+	// It returns the action to take as a result of the expectiminimax algorithm on the input state
+	// with a limit for the depth parameter and a timeout cutoff test
+	action_type decision_up_to_depth(const state_type& root, int depth, timeout_cutoff& timeout){
+		table->new_search();
+		new_search_heuristics();
+		reset_evaluation_statistics();
+
+		arena_scope scope(arena);
+		split_pool_activation activation(split_pool);
+		state_type state = root;
+		gtraits::prepare(state);
+
+		root_order.clear();
+		pv.clear();
+
+		utility_type utility;
+
+		return root_search(state, depth, gtraits::min_utility_value(), gtraits::max_utility_value(), timeout, utility);
+	}
+
+	// Starts pondering on a thread of its own: the search goes on with the position expected to be the root of
+	// the next decision after the action the last one took (see expect_next_root()). The ponder goes on until
+	// stop_pondering() is called or the next decision is asked for. If the root of that decision turns out to
+	// be the expected position (a ponder hit), the decision carries on the search of the ponder instead of
+	// starting over (see decision()); otherwise it is just left with what the ponder stored in the
+	// transposition table. Returns false if there is no position to ponder on.
+	bool start_pondering(){
+		stop_pondering();
+		has_ponder_result = false;
+
+		if (!has_expected_root){
+			return false;
+		}
+
+		// the ponder is the search of the next decision
+		table->new_search();
+		new_search_heuristics();
+
+		ponder_stop = false;
+		ponder_thread = std::thread([this](){
+			ponder_search(expected_root);
+		});
+
+		return true;
+	}
+
+	// Stops the ponder (if any) and waits for its thread to finish
+	void stop_pondering(){
+		if (ponder_thread.joinable()){
+			ponder_stop = true;
+			ponder_thread.join();
+		}
+	}
+
+	// Whether the last decision was made on the position pondered before it
+	bool ponder_hit() const{
+		return last_ponder_hit;
+	}
+
+	// Forgets everything learned from the decisions so far, for a new game
+	void new_game(){
+		stop_pondering();
+
+		table->clear();
+		if (evaluations){
+			evaluations->clear();
+		}
+		heuristics.clear();
+		for (std::size_t i = 0; i < split_workers.size(); ++i){
+			split_workers[i]->heuristics.clear();
+		}
+		root_order.clear();
+		pv.clear();
+		has_ponder_result = false;
+		last_ponder_hit = false;
+		has_expected_root = false;
+	}
+
+	// The probes of the evaluation cache and their hits in the last decision (since decision() or
+	// decision_up_to_depth() was last called), summed over its helpers and the threads it splits its nodes to
+	// (it must not be called while a search or a ponder is running)
+	evaluation_cache_statistics evaluation_statistics() const{
+		evaluation_cache_statistics statistics = evaluation_counts;
+
+		for (std::size_t i = 0; i < helpers.size(); ++i){
+			statistics += helpers[i]->evaluation_statistics();
+		}
+		for (std::size_t i = 0; i < split_workers.size(); ++i){
+			statistics += split_workers[i]->evaluation_statistics();
+		}
+
+		return statistics;
+	}
+
+	// Sets the aspiration window of the iterative deepening: each iteration (after the first) is searched with
+	// the window (score - window, score + window) around the score of the previous iteration. When the score
+	// falls outside it, the side it fell out of is widened by the given factor and the iteration is searched
+	// again. A window of zero (the default) searches every iteration with the full window.
+	void set_aspiration_window(utility_type window, double widening){
+		aspiration_window = window;
+		aspiration_widening = widening;
+	}
+
+	// Sets whether the decisions manage their time (the default) or always deepen until their time is up. A
+	// managed decision doesn't start an iteration that it predicts won't finish in time, and it stops
+	// deepening once it has spent a target share of its time, which is smaller when the best action has been
+	// the same for a few iterations and larger when it changes or the value swings by more than the
+	// aspiration window (see time_manager). A decision with a single action takes no time at all.
+	void set_time_management(bool enabled){
+		timing.enable(enabled);
+	}
+
+	// Sets the number of threads each decision searches with (Lazy SMP). Besides the thread that makes the
+	// decision, threads - 1 helpers run the same iterative deepening on the same state until the decision is
+	// made. They share nothing with it but the transposition table, where every result one thread stores can
+	// cut the search of the others. To spread them over the tree, half of the helpers search one ply deeper
+	// than the others and each pair of them starts with a different action of the root (see helper_search()).
+	void set_threads(unsigned int threads){
+		stop_pondering();
+		helpers.clear();
+
+		for (unsigned int i = 1; i < threads; ++i){
+			helpers.push_back(std::unique_ptr<iterative_deepening_alpha_beta_expectiminimax>(new iterative_deepening_alpha_beta_expectiminimax(*this, i)));
+		}
+	}
+
+	// Sets the number of threads each search runs on with the Young Brothers Wait Concept. Once the first child
+	// of a node (the eldest brother) has been searched without a cutoff, the rest of its children are searched
+	// in parallel by a pool of threads that steal them from each other (see split()). Only the nodes searched
+	// with at least the given depth are split, the smaller subtrees aren't worth the overhead. This mode is
+	// an alternative to the helpers of set_threads(), which don't split their nodes.
+	void set_split_threads(unsigned int threads, int _min_split_depth = default_min_split_depth){
+		stop_pondering();
+		split_workers_pool.reset();
+		split_workers.clear();
+		split_pool = 0;
+		min_split_depth = _min_split_depth;
+
+		if (threads < 2){
+			return;
+		}
+
+		// thread i of the pool searches with split_workers[i - 1], the owner of the search is thread 0
+		for (unsigned int i = 1; i < threads; ++i){
+			split_workers.push_back(std::unique_ptr<iterative_deepening_alpha_beta_expectiminimax>(new iterative_deepening_alpha_beta_expectiminimax(*this, 0)));
+		}
+
+		split_workers_pool.reset(new split_pool_type(threads, [this](std::size_t i, split_task& task){
+			split_workers[i - 1]->run_split_task(task);
+		}));
+
+		split_pool = split_workers_pool.get();
+
+		for (unsigned int i = 1; i < threads; ++i){
+			split_workers[i - 1]->split_pool = split_pool;
+			split_workers[i - 1]->split_index = i;
+			split_workers[i - 1]->min_split_depth = min_split_depth;
+		}
+	}
+private:
+	// constructs a helper of the given search (see set_threads())
+	iterative_deepening_alpha_beta_expectiminimax(const iterative_deepening_alpha_beta_expectiminimax& main, int id) : cutoff(main.cutoff), table(main.table), evaluations(main.evaluations), aspiration_window(), aspiration_widening(2), root_depth(0), following_pv(false), has_partial_action(false), helper_id(id), split_pool(0), split_index(0), min_split_depth(main.min_split_depth), ponder_stop(false), has_ponder_result(false), last_ponder_hit(false), has_expected_root(false){}
+
+	// The iterative deepening of the decision: the root is searched with increasing values of depth, starting
+	// from the given one, until the timeout expires (or the time manager, if any, doesn't start another
+	// iteration). actions holds the best action of each iteration completed and score the value of the last
+	// one. When the timeout expires, we return the action the interrupted iteration has proved to be the best
+	// so far (see root_search()), if any, or else the action selected from the deepest search that has been
+	// completed.
+	action_type deepen(state_type& state, int depth, timeout_cutoff& timeout, std::stack<action_type>& actions, utility_type& score, time_manager* manager = 0){
+		for (;; ++depth){
+			has_partial_action = false;
+
+			utility_type previous_score = score;
+			action_type action = depth == 0 ? root_search(state, depth, gtraits::min_utility_value(), gtraits::max_utility_value(), timeout, score) : aspiration_search(state, depth, timeout, score);
+
+			// if the timeout has expired
+			if (timeout()){
+				if (has_partial_action){
+					return partial_action;
+				}
+
+				// that is the action at the top of the stack unless the stack is empty
+				return actions.empty() ? action : actions.top();
+			}
+
+			if (manager != 0){
+				bool best_changed = !actions.empty() && !(actions.top() == action);
+				bool swing = !actions.empty() && aspiration_window > utility_type() && (score > previous_score ? score - previous_score : previous_score - score) > aspiration_window;
+
+				manager->iteration_done(best_changed, swing);
+			}
+
+			actions.push(action);
+			pv = pv_lines[0];
+
+			// the root order holds every action of the root once an iteration is completed
+			if (manager != 0 && !manager->next_iteration(root_order.size())){
+				return action;
+			}
+		}
+	}
+
+	// Moves the state to its child by the given action, or by the first action in the order of the game if it
+	// is null. Returns false if the state has no such child.
+	bool follow(state_type& state, const action_type* action){
+		state_type child;
+		bool found = false;
+
+		{
+			successor_generator_type children(state, successors, action_order, action);
+
+			if (children.next() && (action == 0 || children.action() == *action)){
+				child = children.state();
+				found = true;
+			}
+		}
+
+		if (found){
+			state = child;
+		}
+		return found;
+	}
+
+	// Works out the position expected at the root of the next decision, after the given action is taken at the
+	// root of this one: the opponent replies with the action of the principal variation (if the variation
+	// starts with the given action), or else with the best action the transposition table knows or the first
+	// one in the order of the game, and every chance node along the way gets its most probable outcome. The
+	// rest of the principal variation is kept for the next decision to start from.
+	void expect_next_root(const state_type& root, const action_type& action){
+		has_expected_root = false;
+		expected_pv.clear();
+
+		expected_root = root;
+
+		bool on_pv = !pv.empty() && pv[0] == action;
+		std::size_t ply = 1;
+
+		// our action and the outcome of the chance node it may lead to (which takes a ply of the variation)
+		if (expected_root.node_type() == StateNodeType::CHANCE_NODE || !follow(expected_root, &action) || cutoff(expected_root)){
+			return;
+		}
+		if (expected_root.node_type() == StateNodeType::CHANCE_NODE){
+			resolve_chance(expected_root);
+			++ply;
+		}
+
+		// the reply and its outcome
+		transposition_entry e;
+		const action_type* reply = 0;
+
+		if (on_pv && ply < pv.size()){
+			reply = &pv[ply];
+		}
+		else if (table->probe(gtraits::hash(expected_root), e) && e.has_action){
+			reply = &e.action;
+			on_pv = false;
+		}
+		else{
+			on_pv = false;
+		}
+
+		if (cutoff(expected_root) || !follow(expected_root, reply)){
+			return;
+		}
+		++ply;
+
+		if (expected_root.node_type() == StateNodeType::CHANCE_NODE){
+			resolve_chance(expected_root);
+			++ply;
+		}
+
+		if (cutoff(expected_root)){
+			return;
+		}
+
+		if (on_pv && ply < pv.size()){
+			expected_pv.assign(pv.begin() + ply, pv.end());
+		}
+		has_expected_root = true;
+	}
+
+	// Starts the search of a new root from the principal variation expected for it (if it was the expected
+	// root) or from scratch
+	void start_principal_variation(bool expected){
+		root_order.clear();
+		pv.clear();
+
+		if (expected && !expected_pv.empty()){
+			pv = expected_pv;
+			root_order.push_back(pv[0]);
+		}
+	}
+
+	// Moves a chance node to its most probable outcome
+	void resolve_chance(state_type& state){
+		state_type child;
+		bool found = false;
+
+		{
+			successor_generator_type children(state, successors, action_order, 0);
+			double probability = 0;
+
+			while (children.next()){
+				if (!found || children.probability() > probability){
+					child = children.state();
+					probability = children.probability();
+					found = true;
+				}
+			}
+		}
+
+		if (found){
+			state = child;
+		}
+	}
+
+	// The iterative deepening of the ponder (see start_pondering()). It keeps the deepest iteration completed
+	// for the decision to go on from.
+	void ponder_search(const state_type& root){
+		// there is no time limit, only the stop flag
+		unsigned int msec = std::numeric_limits<unsigned int>::max();
+		timeout_cutoff timeout(msec, ponder_stop);
+		arena_scope scope(arena);
+		helper_threads running_helpers(*this, root, msec);
+		split_pool_activation activation(split_pool);
+
+		state_type state = root;
+		gtraits::prepare(state);
+		std::stack<action_type> actions;
+		utility_type score = utility_type();
+
+		start_principal_variation(true);
+
+		deepen(state, 0, timeout, actions, score);
+
+		if (!actions.empty()){
+			ponder_key = gtraits::hash(state);
+			ponder_depth = static_cast<int>(actions.size());
+			ponder_score = score;
+			ponder_action = actions.top();
+			has_ponder_result = true;
+		}
+	}
+
+	// Runs the helpers of a search on threads of their own while the object lives
+	class helper_threads{
+	public:
+		helper_threads(iterative_deepening_alpha_beta_expectiminimax& main, const state_type& root, unsigned int msec) : stop(false){
+			for (std::size_t i = 0; i < main.helpers.size(); ++i){
+				iterative_deepening_alpha_beta_expectiminimax* helper = main.helpers[i].get();
+
+				helper->set_aspiration_window(main.aspiration_window, main.aspiration_widening);
+				threads.push_back(std::thread([this, helper, &root, msec](){
+					helper->helper_search(root, msec, stop);
+				}));
+			}
+		}
+
+		helper_threads(const helper_threads&) = delete;
+		helper_threads& operator=(const helper_threads&) = delete;
+
+		// the helpers are stopped when the decision is made
+		~helper_threads(){
+			stop = true;
+
+			for (std::size_t i = 0; i < threads.size(); ++i){
+				threads[i].join();
+			}
+		}
+	private:
+		std::atomic<bool> stop;
+		std::vector<std::thread> threads;
+	};
+
+	// The iterative deepening of a helper thread. It goes on until the stop flag is set or the timeout expires and
+	// its results reach the decision only through the transposition table.
+	void helper_search(const state_type& root, unsigned int msec, const std::atomic<bool>& stop){
+		timeout_cutoff timeout(msec, stop);
+		arena_scope scope(arena);
+
+		state_type state = root;
+		gtraits::prepare(state);
+
+		heuristics.new_search();
+		root_order.clear();
+		pv.clear();
+
+		utility_type score = utility_type();
+		int first_depth = helper_id%2;
+
+		for (int depth = first_depth; !timeout(); ++depth){
+			if (depth == first_depth){
+				root_search(state, depth, gtraits::min_utility_value(), gtraits::max_utility_value(), timeout, score);
+
+				// start the next iterations from a different root action than the helpers before
+				if (!root_order.empty()){
+					std::rotate(root_order.begin(), root_order.begin() + (helper_id/2)%root_order.size(), root_order.end());
+				}
+			}
+			else{
+				aspiration_search(state, depth, timeout, score);
+			}
+
+			if (!timeout()){
+				pv = pv_lines[0];
+			}
+		}
+	}
+
+	// Searches the root with the given window and returns the best action, its value in utility. The window is
+	// fail hard like at the other nodes: a utility of a means that no action is better than a (and the action
+	// returned is meaningless) and a utility of b that the action returned is at least b.
+	//
+	// The first action (the most promising one) is searched with the (a,b) window and every other one with a
+	// null window just above the best value so far, which is enough to prove that it is not better. Only the
+	// actions that turn out to be better are searched again with the full window (principal variation search).
+	//
+	// The actions are walked in the order left by the previous search of the root (see update_root_order()) and
+	// the first one follows the principal variation of the previous iteration down the tree.
+	//
+	// If the timeout expires the search stops. The values found after that are meaningless, but everything
+	// decided before it still holds: the first action, once its search is over, and every later action whose
+	// null window search proved it better than the best one before it. The last of these is kept in
+	// partial_action so that an interrupted iteration is not wasted.
+	action_type root_search(state_type& state, int depth, utility_type a, utility_type b, timeout_cutoff& timeout, utility_type& utility){
+		successor_generator_type children(state, successors, action_order, root_order.empty() ? 0 : &root_order[0], root_order.size(), &heuristics, 0);
+
+		action_type result;
+		bool found = false;
+
+		root_depth = depth;
+		following_pv = !pv.empty() && !root_order.empty() && pv[0] == root_order[0];
+		root_scores.clear();
+
+		// one line for each ply from the root down to the leaves
+		pv_lines.resize(depth + 2);
+		clear_principal_variation(0);
+
+		// For each next state
+		while (children.next()){
+			utility_type current_utility;
+
+			if (!found){
+				// if the timeout expires before any action is searched, the first one is still a legal answer
+				result = children.action();
+				current_utility = exp_minimax_value(children.state(), a, b, depth, timeout);
+			}
+			else{
+				current_utility = exp_minimax_value(children.state(), a, a + 1, depth, timeout);
+
+				if (gtraits::utility_cmp(current_utility, a) > 0 && !timeout()){
+					partial_action = children.action();
+					has_partial_action = true;
+
+					if (gtraits::utility_cmp(current_utility, b) < 0){
+						current_utility = exp_minimax_value(children.state(), a, b, depth, timeout);
+					}
+				}
+			}
+			following_pv = false;
+
+			if (timeout()){
+				break;
+			}
+
+			root_scores.push_back(std::make_pair(children.action(), current_utility));
+
+			// If the utility of the current state is better (max) then
+			// mark it as the result. The first action is the result until another one beats it.
+			if (!found || gtraits::utility_cmp(current_utility, a) > 0){
+				result = children.action();
+				found = true;
+				partial_action = result;
+				has_partial_action = true;
+			}
+
+			if (gtraits::utility_cmp(current_utility, a) > 0){
+				a = current_utility;
+				update_principal_variation(0, children.action());
+			}
+
+			if (gtraits::utility_cmp(a, b) >= 0){
+				utility = b;
+				update_root_order(result, timeout);
+				return result;
+			}
+		}
+
+		// At the end the result holds the action that led to the state with the maximum value
+		utility = a;
+		update_root_order(result, timeout);
+		return result;
+	}
+
+	// Orders the actions of the root for the next search by the values they got in the last one, the best action
+	// first. Most of the values are just the bounds the null windows proved, so the actions that got the same
+	// value keep their previous order, and the actions left unsearched by a cutoff go last. The order is kept
+	// as it was if the search was interrupted by the timeout.
+	void update_root_order(const action_type& best, timeout_cutoff& timeout){
+		if (timeout()){
+			return;
+		}
+
+		std::stable_sort(root_scores.begin(), root_scores.end(), [](const std::pair<action_type, utility_type>& x, const std::pair<action_type, utility_type>& y) -> bool{
+			return gtraits::utility_cmp(x.second, y.second) > 0;
+		});
+
+		std::size_t num_searched = root_scores.size();
+
+		next_root_order.clear();
+		next_root_order.push_back(best);
+
+		for (std::size_t i = 0; i < num_searched; ++i){
+			if (!(root_scores[i].first == best)){
+				next_root_order.push_back(root_scores[i].first);
+			}
+		}
+
+		for (std::size_t i = num_searched; i < root_order.size(); ++i){
+			if (std::find(next_root_order.begin(), next_root_order.end(), root_order[i]) == next_root_order.end()){
+				next_root_order.push_back(root_order[i]);
+			}
+		}
+
+		root_order.swap(next_root_order);
+	}
+
+	// The principal variation of each node is collected in a triangular table: the line of the node at a ply is
+	// its best action followed by the line of the child it leads to (one ply further). The line of a chance node
+	// goes on with its first outcome, which is where the next iteration will follow it as well (the action
+	// stored for the chance node is never looked at, it only keeps the plies of the variation in step).
+	void clear_principal_variation(std::size_t ply){
+		if (ply < pv_lines.size()){
+			pv_lines[ply].clear();
+		}
+	}
+
+	void update_principal_variation(std::size_t ply, const action_type& action){
+		if (ply + 1 < pv_lines.size()){
+			pv_lines[ply].clear();
+			pv_lines[ply].push_back(action);
+			pv_lines[ply].insert(pv_lines[ply].end(), pv_lines[ply + 1].begin(), pv_lines[ply + 1].end());
+		}
+	}
+
+	// the ply of a node searched with the given depth (every ply takes one off the depth)
+	std::size_t ply_of(int depth) const{
+		return root_depth - depth + 1;
+	}
+
+	// Returns the action of the principal variation of the previous iteration to walk first at a node searched
+	// with the given depth, if the node lies on that variation (and null otherwise)
+	const action_type* principal_variation_action(int depth) const{
+		if (!following_pv){
+			return 0;
+		}
 
-	// constructor
-	iterative_deepening_alpha_beta_expectiminimax(const cutoff_test_type& _cutoff = cutoff_test_type()) : cutoff(_cutoff){}
+		std::size_t ply = ply_of(depth);
 
-	// It returns the action to take as a result of the expectiminimax algorithm on the input state
-	action_type decision(const state_type& state, unsigned int msec){
-		// we apply iterative deepening with increasing values of depth.
-		// When timeout expires, we return the move selected from the deepest search that has been completed
-		timeout_cutoff timeout(msec);
-		std::stack<action_type> actions;
+		return ply < pv.size() ? &pv[ply] : 0;
+	}
 
-		int max_depth = std::numeric_limits<int>::max();
+	// Searches the root with an aspiration window around the score of the previous iteration (see
+	// set_aspiration_window()) and widens it until the score falls inside. score is updated to the new one.
+	action_type aspiration_search(state_type& state, int depth, timeout_cutoff& timeout, utility_type& score){
+		double min_value = gtraits::min_utility_value();
+		double max_value = gtraits::max_utility_value();
 
-		for (int depth = 0; depth < max_depth; ++depth){
-			action_type action = decision_up_to_depth(state, depth, timeout);
+		if (aspiration_window <= 0){
+			return root_search(state, depth, gtraits::min_utility_value(), gtraits::max_utility_value(), timeout, score);
+		}
 
-			// if the timeout has expired
-			if (timeout()){
-				// then we choose the action selected from the deepest search that has been completed
-				// that is from the action at the top of the stack unless the stack is empty
-				return actions.empty() ? action : actions.top();
+		// the window is computed in double so that it doesn't overflow near the ends of the utility range
+		double lower_width = aspiration_window;
+		double upper_width = aspiration_window;
+
+		for (;;){
+			utility_type a = score - lower_width <= min_value ? gtraits::min_utility_value() : static_cast<utility_type>(score - lower_width);
+			utility_type b = score + upper_width >= max_value ? gtraits::max_utility_value() : static_cast<utility_type>(score + upper_width);
+			utility_type utility;
+
+			action_type action = root_search(state, depth, a, b, timeout, utility);
+
+			// fail low: every action may be worse than the window, widen it downwards
+			if (gtraits::utility_cmp(utility, a) <= 0 && gtraits::utility_cmp(a, gtraits::min_utility_value()) > 0 && !timeout()){
+				widen(lower_width);
+				continue;
 			}
-			actions.push(action);
-		}
 
-		assert(!actions.empty());
+			// fail high: the action is better than the window, widen it upwards to find out by how much
+			if (gtraits::utility_cmp(utility, b) >= 0 && gtraits::utility_cmp(b, gtraits::max_utility_value()) < 0 && !timeout()){
+				widen(upper_width);
+				continue;
+			}
 
-		return actions.top();
+			score = utility;
+			return action;
+		}
 	}
 
-	// It returns the action to take as a result of the expectiminimax algorithm on the input state
-	// with a limit for the depth parameter and a timeout cutoff test
-	action_type decision_up_to_depth(const state_type& state, int depth, timeout_cutoff& timeout){
-		/**
-		 * We must choose the action maximizing the values we receive from each state we get after applying
-		 * each valid action on the current state.
-		 * So first get the actions and the states for the current state using successors()
-		 * and then we apply the action ordering optimization.
-		 */
-		std::list<std::tuple<action_type,state_type,double> > actions = std::move(successors(state));
-		action_order(actions);
+	// Widens one side of the aspiration window (a widening factor of at most 1 opens it up entirely)
+	void widen(double& width) const{
+		width = aspiration_widening > 1 ? width*aspiration_widening : std::numeric_limits<double>::infinity();
+	}
 
-		typedef typename std::list<std::tuple<action_type,state_type,double> >::iterator iterator;
+	/**
+	 * A split point is a node whose children (after the first) are being searched in parallel. Each child is a
+	 * task holding a copy of the child state, and every thread that takes a task searches it with the current
+	 * window of the node and reports its value back. The thread that split the node runs the tasks left in its
+	 * own queue and waits for those stolen by the other threads. When a child causes a cutoff the split point
+	 * is aborted, which stops the searches of the other children (their timeouts expire).
+	 *
+	 * For a chance node each child has the Star1 window computed when the node was split, from the value of the
+	 * first child and the bounds of all the others (which is looser than the window it would get searched after
+	 * its elder brothers, but valid on its own).
+	 */
+	struct split_point{
+		std::mutex mutex;
+		std::atomic<bool> abort;
+		std::atomic<int> pending; // the number of tasks not finished yet
 
+		StateNodeType type;
+		int depth;
+		int root_depth;
+		timeout_cutoff::time_point time_limit;
 
-		utility_type utility = gtraits::min_utility_value();
-		iterator result = actions.begin();
+		// guarded by the mutex
+		utility_type a, b; // the window of a max or min node, narrowed as its children are searched
+		action_type best; // the best action found by the tasks (if has_best)
+		bool has_best;
+		bool fail_low, fail_high; // whether the node is proved to be at most a, at least b
+		double utility; // the sum of probability*value of the children of a chance node searched by the tasks
 
-		// For each next state
-		for (iterator first = actions.begin(), last = actions.end(); first != last; ++first){
-			utility_type current_utility = exp_minimax_value(std::get<1>(*first), gtraits::min_utility_value(), gtraits::max_utility_value(), depth, timeout);
+		// the children of a chance node: their probabilities, bounds and windows (kept by the splitting thread)
+		const double* probability;
+		const utility_type* lower;
+		const utility_type* upper;
+		const double* window_a;
+		const double* window_b;
+	};
 
-			// If the utility of the current state is better (max) then
-			// mark it in the result iterator.
-			if (current_utility > utility){
-				utility = current_utility;
-				result = first;
+	struct split_task{
+		split_point* point;
+		state_type state; // a copy of the child state
+		action_type action; // the action leading to it
+		std::size_t index; // the index of the child
+	};
+
+	typedef work_stealing_pool<split_task> split_pool_type;
+
+	// Makes the threads of the pool look for work during a search
+	class split_pool_activation{
+	public:
+		explicit split_pool_activation(split_pool_type* _pool) : pool(_pool){
+			if (pool != 0){
+				pool->activate();
 			}
 		}
 
-		// At the end the result iterator points to the tuple that had the state with the maximum
-		// value
-		return std::get<0>(*result);
-	}
-private:
+		split_pool_activation(const split_pool_activation&) = delete;
+		split_pool_activation& operator=(const split_pool_activation&) = delete;
+
+		~split_pool_activation(){
+			if (pool != 0){
+				pool->deactivate();
+			}
+		}
+	private:
+		split_pool_type* pool;
+	};
+
 	cutoff_test_type cutoff;
 	evaluation_function_type eval;
 	successors_function_type successors;
 	action_ordering_type action_order;
+	std::shared_ptr<transposition_table_type> table; // shared with the helpers
+	std::shared_ptr<evaluation_cache_type> evaluations; // shared with the helpers (null if there is no cache)
+	evaluation_cache_statistics evaluation_counts; // the probes of the cache by this search (not its helpers)
+	heuristics_type heuristics; // the killer and history heuristics of the action ordering
+	monotonic_arena arena;
+	utility_type aspiration_window;
+	double aspiration_widening;
+
+	// the actions of the root in the order to search them and the values they got in the current search of
+	// the root (next_root_order is just a buffer)
+	std::vector<action_type> root_order;
+	std::vector<action_type> next_root_order;
+	std::vector<std::pair<action_type, utility_type> > root_scores;
+
+	// the principal variation of the previous iteration (starting with the action of the root), the lines of
+	// the principal variation of the current one (see update_principal_variation()), the depth the root is being
+	// searched with and whether the node being searched lies on the previous variation
+	std::vector<action_type> pv;
+	std::vector<std::vector<action_type> > pv_lines;
+	int root_depth;
+	bool following_pv;
+
+	// the best action proved by the searches of the root of the current iteration so far (see root_search())
+	action_type partial_action;
+	bool has_partial_action;
+
+	// the helpers of the search (see set_threads()) and, for a helper, its number (starting from 1)
+	std::vector<std::unique_ptr<iterative_deepening_alpha_beta_expectiminimax> > helpers;
+	int helper_id;
+
+	// the searches run by the threads of the pool that splits the nodes (see set_split_threads()) and the pool
+	// itself, declared after them so that its threads are joined first. split_pool is the pool the search
+	// splits its nodes to (owned by the search that made it) and split_index the queue of the search in it.
+	std::vector<std::unique_ptr<iterative_deepening_alpha_beta_expectiminimax> > split_workers;
+	std::unique_ptr<split_pool_type> split_workers_pool;
+	split_pool_type* split_pool;
+	std::size_t split_index;
+	int min_split_depth;
+
+	// the thread of the ponder and its stop flag (see start_pondering()). When the ponder has completed an
+	// iteration it leaves the key of the position it pondered on, the depth of the first iteration it didn't
+	// complete, the value and the best action of the last one.
+	std::thread ponder_thread;
+	std::atomic<bool> ponder_stop;
+	std::uint64_t ponder_key;
+	int ponder_depth;
+	utility_type ponder_score;
+	action_type ponder_action;
+	bool has_ponder_result;
+	bool last_ponder_hit;
+
+	// the position expected at the root of the next decision and the rest of the principal variation from it
+	// (see expect_next_root())
+	state_type expected_root;
+	std::vector<action_type> expected_pv;
+	bool has_expected_root;
+
+	// the time management of the decisions, which learns the branching factor of the search from one decision
+	// to the next
+	time_manager timing;
+
+	// Starts a new search of the heuristics, those of the searches of the split workers too (the helpers start
+	// their own, see helper_search()). The pool must not be active.
+	void new_search_heuristics(){
+		heuristics.new_search();
+
+		for (std::size_t i = 0; i < split_workers.size(); ++i){
+			split_workers[i]->heuristics.new_search();
+		}
+	}
+
+	// Zeroes the counts of the probes of the evaluation cache, those of the helpers and the split workers too
+	// (none of them may be running)
+	void reset_evaluation_statistics(){
+		evaluation_counts = evaluation_cache_statistics();
+
+		for (std::size_t i = 0; i < helpers.size(); ++i){
+			helpers[i]->reset_evaluation_statistics();
+		}
+		for (std::size_t i = 0; i < split_workers.size(); ++i){
+			split_workers[i]->reset_evaluation_statistics();
+		}
+	}
+
+	// Whether the children of a node searched with the given depth should be searched in parallel
+	bool splits(int depth) const{
+		return split_pool != 0 && depth >= min_split_depth;
+	}
+
+	// Initializes a split point for the node searched with the given depth and window
+	void init_split_point(split_point& point, StateNodeType type, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+		point.abort = false;
+		point.pending = 0;
+		point.type = type;
+		point.depth = depth;
+		point.root_depth = root_depth;
+		point.time_limit = timeout.time_limit();
+		point.a = a;
+		point.b = b;
+		point.has_best = false;
+		point.fail_low = false;
+		point.fail_high = false;
+		point.utility = 0;
+		point.probability = 0;
+		point.lower = 0;
+		point.upper = 0;
+		point.window_a = 0;
+		point.window_b = 0;
+	}
+
+	// Turns the children left in the generator into tasks of the split point and waits until they are all
+	// searched. first_index is the index of the first of them. The tasks hold whole states and the search may
+	// split many nodes before the decision returns, so they don't come from the arena (which is only released
+	// then) but from the heap.
+	//
+	// While it waits, the thread searches the tasks of its split point that no other thread has taken, and
+	// once there are none it helps with the tasks of the other split points of the same or a greater ply (the
+	// ones below it in the tree, often the splits of the threads searching its own tasks). Those only use the
+	// lines of the principal variation and the plies of the heuristics below the split point, so they leave
+	// the ancestors of the node alone, and the splits nested this way get ever deeper.
+	void split(split_point& point, successor_generator_type& children, std::size_t first_index, timeout_cutoff& timeout){
+		std::vector<split_task> tasks;
+
+		for (std::size_t i = first_index; children.next(); ++i){
+			split_task task;
+
+			task.point = &point;
+			task.state = children.state();
+			task.action = children.action();
+			task.index = i;
+			tasks.push_back(task);
+		}
+
+		point.pending = static_cast<int>(tasks.size());
+
+		// the queue is popped from the back, so the last child goes in first to run the children in order
+		for (std::size_t i = tasks.size(); i > 0; --i){
+			split_pool->push(split_index, tasks[i - 1]);
+		}
+
+		split_task task;
+		std::size_t ply = point_ply(point);
+
+		while (point.pending.load() > 0){
+			// a timeout (or the abort of an enclosing split point) stops the children as well
+			if (timeout()){
+				point.abort = true;
+			}
+
+			if (split_pool->pop(split_index, task, [&point](const split_task& t){ return t.point == &point; })){
+				run_split_task(task);
+			}
+			else if (split_pool->steal(split_index, task, [this, ply](const split_task& t){ return point_ply(*t.point) >= ply; })){
+				run_split_task(task);
+			}
+			else{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	// the ply of the node of a split point (see ply_of())
+	static std::size_t point_ply(const split_point& point){
+		return point.root_depth - point.depth + 1;
+	}
+
+	// Searches the child of a split point
+	void run_split_task(split_task& task){
+		split_point& point = *task.point;
+
+		if (!point.abort.load()){
+			timeout_cutoff timeout(point.time_limit, point.abort);
+			arena_scope scope(arena);
+
+			// the child is at the plies of the search that split the node
+			int saved_root_depth = root_depth;
+			bool saved_following_pv = following_pv;
+
+			root_depth = point.root_depth;
+			following_pv = false;
+
+			if (pv_lines.size() < static_cast<std::size_t>(root_depth) + 2){
+				pv_lines.resize(root_depth + 2);
+			}
+
+			if (point.type == StateNodeType::CHANCE_NODE){
+				search_chance_split_task(task, point, timeout);
+			}
+			else{
+				search_split_task(task, point, timeout);
+			}
+
+			root_depth = saved_root_depth;
+			following_pv = saved_following_pv;
+		}
+
+		// the split point may be gone as soon as this is done
+		point.pending.fetch_sub(1);
+	}
+
+	// Searches a younger brother of a max or min node: first with a null window at the edge of the current
+	// window (enough to prove that it is not better) and only if it is better again with the full window
+	void search_split_task(split_task& task, split_point& point, timeout_cutoff& timeout){
+		bool max_node = point.type == StateNodeType::MAX_NODE;
+		utility_type a, b;
+
+		{
+			std::lock_guard<std::mutex> lock(point.mutex);
+			a = point.a;
+			b = point.b;
+		}
+
+		if (gtraits::utility_cmp(a, b) >= 0){
+			return;
+		}
+
+		utility_type value = max_node ? exp_minimax_value(task.state, a, a + 1, point.depth - 1, timeout) : exp_minimax_value(task.state, b - 1, b, point.depth - 1, timeout);
+		bool better = max_node ? gtraits::utility_cmp(value, a) > 0 : gtraits::utility_cmp(value, b) < 0;
+
+		if (!better || timeout()){
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(point.mutex);
+			a = point.a;
+			b = point.b;
+		}
+
+		if (gtraits::utility_cmp(a, b) >= 0){
+			return;
+		}
+
+		value = exp_minimax_value(task.state, a, b, point.depth - 1, timeout);
+
+		if (timeout()){
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(point.mutex);
+
+		if (max_node && gtraits::utility_cmp(value, point.a) > 0){
+			point.a = value;
+			point.best = task.action;
+			point.has_best = true;
+		}
+		else if (!max_node && gtraits::utility_cmp(value, point.b) < 0){
+			point.b = value;
+			point.best = task.action;
+			point.has_best = true;
+		}
+
+		if (gtraits::utility_cmp(point.a, point.b) >= 0){
+			(max_node ? point.fail_high : point.fail_low) = true;
+			point.abort = true;
+		}
+	}
+
+	// Searches a child of a chance node with its Star1 window
+	void search_chance_split_task(split_task& task, split_point& point, timeout_cutoff& timeout){
+		std::size_t i = task.index;
+		utility_type value = exp_minimax_value(task.state, child_window_lower(point.window_a[i], point.lower[i]), child_window_upper(point.window_b[i], point.upper[i]), point.depth - 1, timeout);
+
+		if (timeout()){
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(point.mutex);
+
+		if (value <= point.window_a[i]){
+			point.fail_low = true;
+			point.abort = true;
+		}
+		else if (value >= point.window_b[i]){
+			point.fail_high = true;
+			point.abort = true;
+		}
+		else{
+			point.utility += point.probability[i]*value;
+		}
+	}
+
+	// Evaluates the quiet state searched with the window (a, b). If its cheap bounds lie outside the window, the
+	// bound beyond it will do as the value (most of the leaves of the null window searches are far from the
+	// window), otherwise it is evaluated in full.
+	utility_type lazy_eval(const state_type& state, utility_type a, utility_type b){
+		utility_type lower;
+		utility_type upper;
+
+		gtraits::evaluation_bounds(state, lower, upper);
+
+		if (gtraits::utility_cmp(upper, a) <= 0){
+			return upper;
+		}
+		if (gtraits::utility_cmp(lower, b) >= 0){
+			return lower;
+		}
+
+		return cached_eval(state);
+	}
+
+	// Evaluates the state, or takes its value from the evaluation cache if it is there
+	utility_type cached_eval(const state_type& state){
+		if (!evaluations){
+			return eval(state);
+		}
+
+		std::uint64_t key = gtraits::hash(state);
+		utility_type value;
+
+		++evaluation_counts.probes;
+
+		if (evaluations->probe(key, value)){
+			++evaluation_counts.hits;
+			return value;
+		}
+
+		value = eval(state);
+		evaluations->store(key, value);
+
+		return value;
+	}
 
 	// This is a dispatch method that according to the type of the state node (max node, min node, chance node)
 	// it calls the appropriate function to calculate the value.
-	utility_type exp_minimax_value(const state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+	utility_type exp_minimax_value(state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+		// The principal variation of the node is empty until one of its actions proves best
+		clear_principal_variation(ply_of(depth));
+
 		// First we apply uniformly to all state node types the cutoff optimization test.
-		// We also stop if the timeout expires or the depth limit has been reached
-		if (depth == 0 || cutoff(state) || timeout()){
-			return eval(state);
+		// We also stop if the timeout expires
+		if (cutoff(state) || timeout()){
+			return cached_eval(state);
+		}
+
+		// Past the depth limit the search goes on only while the nodes aren't quiet (quiescence search). The
+		// evaluation is the value of a quiet node (it stands pat), while a node that isn't quiet must be
+		// searched since its player has no choice but its few actions. The depth goes on below zero so that
+		// the transposition table and the principal variation keep telling the plies apart.
+		if (depth <= 0 && state.node_type() != StateNodeType::CHANCE_NODE && gtraits::quiet(state)){
+			return lazy_eval(state, a, b);
 		}
 
 		switch(state.node_type()){
@@ -202,72 +1711,441 @@ private:
 	}
 
 	// Calculates the value of a max node (with alpha-beta pruning)
-	utility_type max_node_exp_minimax_value(const state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
-		// Get the next states from the current state
-		std::list<std::tuple<action_type,state_type,double> > actions = std::move(successors(state));
-		// Apply action ordering optimization
-		action_order(actions);
+	utility_type max_node_exp_minimax_value(state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+		// Look the state up in the transposition table. A result of at least the same depth can be used directly
+		// if it is exact or if its bound lies outside the (a,b) window.
+		std::uint64_t key = gtraits::hash(state);
+		transposition_entry entry;
+		bool found = table->probe(key, entry);
 
-		typedef typename std::list<std::tuple<action_type,state_type,double> >::iterator iterator;
+		if (found && entry.depth >= depth){
+			if (entry.bound == BoundType::EXACT){
+				return entry.value;
+			}
+			if (entry.bound == BoundType::LOWER_BOUND && gtraits::utility_cmp(entry.value, b) >= 0){
+				return b;
+			}
+			if (entry.bound == BoundType::UPPER_BOUND && gtraits::utility_cmp(entry.value, a) <= 0){
+				return a;
+			}
+		}
+
+		// Get the next states from the current state, the action of the principal variation or else the best
+		// action of the transposition table first
+		const action_type* first = principal_variation_action(depth);
+		successor_generator_type children(state, successors, action_order, first != 0 ? first : ((found && entry.has_action) ? &entry.action : 0), 1, &heuristics, ply_of(depth));
+
+		utility_type initial_a = a;
+		action_type best;
+		bool has_best = false;
 
 		// For each next state
-		for (iterator first = actions.begin(), last = actions.end(); first != last; ++first){
-			// Get the utility of the current next state
-			utility_type current_utility = exp_minimax_value(std::get<1>(*first), a, b, depth - 1, timeout);
+		while (children.next()){
+			// Get the utility of the current next state (only the first child can be on the principal variation)
+			utility_type current_utility = exp_minimax_value(children.state(), a, b, depth - 1, timeout);
+			following_pv = false;
 
 			// Apply alpha-beta pruning optimization
-			a = gtraits::max_utility_cmp(a, current_utility);
+			if (gtraits::utility_cmp(current_utility, a) > 0){
+				a = current_utility;
+				best = children.action();
+				has_best = true;
+				update_principal_variation(ply_of(depth), best);
+			}
 
 			if (gtraits::utility_cmp(a, b) >= 0){
+				heuristics.cutoff(children.action(), ply_of(depth), depth);
+
+				if (!timeout()){
+					table->store(key, depth, BoundType::LOWER_BOUND, b, &children.action());
+				}
 				return b;
 			}
+
+			// the eldest brother is searched, the others can be searched in parallel
+			if (splits(depth)){
+				split_point point;
+
+				init_split_point(point, StateNodeType::MAX_NODE, a, b, depth, timeout);
+				split(point, children, 1, timeout);
+
+				if (point.has_best){
+					a = point.a;
+					best = point.best;
+					has_best = true;
+					clear_principal_variation(ply_of(depth) + 1);
+					update_principal_variation(ply_of(depth), best);
+				}
+
+				if (point.fail_high){
+					heuristics.cutoff(best, ply_of(depth), depth);
+
+					if (!timeout()){
+						table->store(key, depth, BoundType::LOWER_BOUND, b, &best);
+					}
+					return b;
+				}
+				break;
+			}
+		}
+
+		if (!timeout()){
+			if (has_best){
+				table->store(key, depth, gtraits::utility_cmp(a, initial_a) > 0 ? BoundType::EXACT : BoundType::UPPER_BOUND, a, &best);
+			}
+			else{
+				table->store(key, depth, BoundType::UPPER_BOUND, a, 0);
+			}
 		}
 
 		return a;
 	}
 
 	// Calculates the value of a min node (with alpha-beta pruning)
-	utility_type min_node_exp_minimax_value(const state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
-		// Get the next states from the current state
-		std::list<std::tuple<action_type,state_type,double> > actions = std::move(successors(state));
-		// Apply action ordering optimization
-		action_order(actions);
+	utility_type min_node_exp_minimax_value(state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+		// Look the state up in the transposition table (see max_node_exp_minimax_value())
+		std::uint64_t key = gtraits::hash(state);
+		transposition_entry entry;
+		bool found = table->probe(key, entry);
+
+		if (found && entry.depth >= depth){
+			if (entry.bound == BoundType::EXACT){
+				return entry.value;
+			}
+			if (entry.bound == BoundType::LOWER_BOUND && gtraits::utility_cmp(entry.value, b) >= 0){
+				return b;
+			}
+			if (entry.bound == BoundType::UPPER_BOUND && gtraits::utility_cmp(entry.value, a) <= 0){
+				return a;
+			}
+		}
 
-		typedef typename std::list<std::tuple<action_type,state_type,double> >::iterator iterator;
+		// Get the next states from the current state, the action of the principal variation or else the best
+		// action of the transposition table first
+		const action_type* first = principal_variation_action(depth);
+		successor_generator_type children(state, successors, action_order, first != 0 ? first : ((found && entry.has_action) ? &entry.action : 0), 1, &heuristics, ply_of(depth));
 
-		utility_type utility = gtraits::max_utility_value();
+		utility_type initial_b = b;
+		action_type best;
+		bool has_best = false;
 
 		// For each next state
-		for (iterator first = actions.begin(), last = actions.end(); first != last; ++first){
-			// Get the utility of the current next state
-			utility_type current_utility = exp_minimax_value(std::get<1>(*first), a, b, depth - 1, timeout);
+		while (children.next()){
+			// Get the utility of the current next state (only the first child can be on the principal variation)
+			utility_type current_utility = exp_minimax_value(children.state(), a, b, depth - 1, timeout);
+			following_pv = false;
 
 			// Apply alpha-beta pruning optimization
-			b = gtraits::min_utility_cmp(b, current_utility);
+			if (gtraits::utility_cmp(current_utility, b) < 0){
+				b = current_utility;
+				best = children.action();
+				has_best = true;
+				update_principal_variation(ply_of(depth), best);
+			}
 
 			if (gtraits::utility_cmp(b, a) <= 0){
+				heuristics.cutoff(children.action(), ply_of(depth), depth);
+
+				if (!timeout()){
+					table->store(key, depth, BoundType::UPPER_BOUND, a, &children.action());
+				}
 				return a;
 			}
+
+			// the eldest brother is searched, the others can be searched in parallel
+			if (splits(depth)){
+				split_point point;
+
+				init_split_point(point, StateNodeType::MIN_NODE, a, b, depth, timeout);
+				split(point, children, 1, timeout);
+
+				if (point.has_best){
+					b = point.b;
+					best = point.best;
+					has_best = true;
+					clear_principal_variation(ply_of(depth) + 1);
+					update_principal_variation(ply_of(depth), best);
+				}
+
+				if (point.fail_low){
+					heuristics.cutoff(best, ply_of(depth), depth);
+
+					if (!timeout()){
+						table->store(key, depth, BoundType::UPPER_BOUND, a, &best);
+					}
+					return a;
+				}
+				break;
+			}
+		}
+
+		if (!timeout()){
+			if (has_best){
+				table->store(key, depth, gtraits::utility_cmp(b, initial_b) < 0 ? BoundType::EXACT : BoundType::LOWER_BOUND, b, &best);
+			}
+			else{
+				table->store(key, depth, BoundType::LOWER_BOUND, b, 0);
+			}
 		}
 
 		return b;
 	}
 
-	utility_type chance_node_exp_minimax_value(const state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
-		std::list<std::tuple<action_type,state_type,double> > actions = std::move(successors(state));
-		action_order(actions);
+	// Calculates the value of a chance node. If the utility values are bounded the children are searched with
+	// Ballard's Star2 and Star1 pruning (see below), otherwise all of them are searched with the (a,b) window.
+	utility_type chance_node_exp_minimax_value(state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout){
+		// Look the state up in the transposition table (see max_node_exp_minimax_value())
+		std::uint64_t key = gtraits::hash(state);
+		transposition_entry entry;
+
+		if (table->probe(key, entry) && entry.depth >= depth){
+			if (entry.bound == BoundType::EXACT){
+				return entry.value;
+			}
+			if (entry.bound == BoundType::LOWER_BOUND && gtraits::utility_cmp(entry.value, b) >= 0){
+				return b;
+			}
+			if (entry.bound == BoundType::UPPER_BOUND && gtraits::utility_cmp(entry.value, a) <= 0){
+				return a;
+			}
+		}
+
+		successor_generator_type children(state, successors, action_order, 0);
+
+		std::tuple<bool, utility_type, utility_type> bounds = gtraits::bounded();
+
+		if (!std::get<0>(bounds) || children.size() > max_chance_outcomes){
+			double utility = 0;
+
+			// whether all the outcomes have been valued exactly, that is none of them was cut off at the (a,b) window
+			bool exact = true;
+
+			for (bool first = true; children.next(); first = false){
+				utility_type current_utility = exp_minimax_value(children.state(), a, b, depth - 1, timeout);
+				following_pv = false;
+
+				if (first){
+					update_principal_variation(ply_of(depth), action_type());
+				}
+
+				if (gtraits::utility_cmp(current_utility, a) <= 0 || gtraits::utility_cmp(current_utility, b) >= 0){
+					exact = false;
+				}
+
+				utility += current_utility*children.probability();
+			}
+
+			utility_type result = static_cast<utility_type>(std::floor(utility + 0.5));
+
+			if (exact){
+				store_chance_bound(key, depth, BoundType::EXACT, result, timeout);
+			}
+
+			return result;
+		}
+
+		/**
+		 * Every child value lies within [lower[i], upper[i]], at first the bounds of the utility values. Knowing
+		 * the values of the children searched so far, the chance node can only end up below a (or above b) if
+		 * the next child does so even when all the remaining children take their highest (lowest) values.
+		 * This gives each child a window of its own, usually much narrower than (a,b) and wider for the
+		 * children with small probabilities (Star1).
+		 *
+		 * Before that, if the children are max (min) nodes then searching just the first action of each of them
+		 * gives a lower (upper) bound of its value that tightens the windows of the children searched after it,
+		 * and that may be enough by itself to prove that the chance node is at least b (at most a) (Star2).
+		 */
+		const std::size_t num_children = children.size();
+		double probability[max_chance_outcomes];
+		utility_type lower[max_chance_outcomes];
+		utility_type upper[max_chance_outcomes];
+
+		// the sums of probability*bound over the children not searched yet
+		double lower_mass = 0;
+		double upper_mass = 0;
+
+		for (std::size_t i = 0; i < num_children; ++i){
+			probability[i] = children.probability(i);
+			lower[i] = std::get<1>(bounds);
+			upper[i] = std::get<2>(bounds);
+			lower_mass += probability[i]*lower[i];
+			upper_mass += probability[i]*upper[i];
+		}
+
+		// the principal variation goes on with the search of the first child (not with its probe)
+		bool on_pv = following_pv;
+		following_pv = false;
+
+		// Star2: probe the first action of each child. The probe of a child can only tighten its bound on one
+		// side, so its window is derived from the current bounds of all the other children.
+		if (depth > 1){
+			for (std::size_t i = 0; children.next(); ++i){
+				state_type& child = children.state();
+				StateNodeType type = child.node_type();
+
+				if (type == StateNodeType::CHANCE_NODE || cutoff(child)){
+					continue;
+				}
+
+				double child_a = (a - (upper_mass - probability[i]*upper[i]))/probability[i];
+				double child_b = (b - (lower_mass - probability[i]*lower[i]))/probability[i];
+				utility_type probe_a = child_window_lower(child_a, lower[i]);
+				utility_type probe_b = child_window_upper(child_b, upper[i]);
+
+				utility_type value;
+				if (!probe_first_action(child, probe_a, probe_b, depth - 1, timeout, value)){
+					continue;
+				}
+
+				// the first action of a max node is a lower bound of its value
+				if (type == StateNodeType::MAX_NODE){
+					if (value >= child_b){
+						store_chance_bound(key, depth, BoundType::LOWER_BOUND, b, timeout);
+						return b;
+					}
+					if (gtraits::utility_cmp(value, probe_a) > 0 && gtraits::utility_cmp(value, lower[i]) > 0){
+						lower_mass += probability[i]*(value - lower[i]);
+						lower[i] = value;
+					}
+				}
+				// and of a min node an upper bound
+				else{
+					if (value <= child_a){
+						store_chance_bound(key, depth, BoundType::UPPER_BOUND, a, timeout);
+						return a;
+					}
+					if (gtraits::utility_cmp(value, probe_b) < 0 && gtraits::utility_cmp(value, upper[i]) < 0){
+						upper_mass += probability[i]*(value - upper[i]);
+						upper[i] = value;
+					}
+				}
+			}
+		}
+
+		// Star1: search each child with the window left by the values of the children before it and the bounds
+		// of the children after it
+		successor_generator_type search_children(state, successors, action_order, 0);
+		double utility = 0;
+
+		following_pv = on_pv;
+
+		for (std::size_t i = 0; search_children.next(); ++i){
+			lower_mass -= probability[i]*lower[i];
+			upper_mass -= probability[i]*upper[i];
+
+			double child_a = (a - utility - upper_mass)/probability[i];
+			double child_b = (b - utility - lower_mass)/probability[i];
+
+			// the bounds known for the child may be enough to decide
+			if (upper[i] <= child_a){
+				store_chance_bound(key, depth, BoundType::UPPER_BOUND, a, timeout);
+				return a;
+			}
+			if (lower[i] >= child_b){
+				store_chance_bound(key, depth, BoundType::LOWER_BOUND, b, timeout);
+				return b;
+			}
+
+			utility_type current_utility = exp_minimax_value(search_children.state(), child_window_lower(child_a, lower[i]), child_window_upper(child_b, upper[i]), depth - 1, timeout);
+			following_pv = false;
+
+			if (i == 0){
+				update_principal_variation(ply_of(depth), action_type());
+			}
+
+			if (current_utility <= child_a){
+				store_chance_bound(key, depth, BoundType::UPPER_BOUND, a, timeout);
+				return a;
+			}
+			if (current_utility >= child_b){
+				store_chance_bound(key, depth, BoundType::LOWER_BOUND, b, timeout);
+				return b;
+			}
+
+			utility += probability[i]*current_utility;
+
+			// the first child is searched, the others can be searched in parallel (all of them need to be searched
+			// anyway unless one of them fails)
+			if (splits(depth) && i + 1 < num_children){
+				double window_a[max_chance_outcomes];
+				double window_b[max_chance_outcomes];
+
+				for (std::size_t j = i + 1; j < num_children; ++j){
+					window_a[j] = (a - utility - (upper_mass - probability[j]*upper[j]))/probability[j];
+					window_b[j] = (b - utility - (lower_mass - probability[j]*lower[j]))/probability[j];
+
+					if (upper[j] <= window_a[j]){
+						store_chance_bound(key, depth, BoundType::UPPER_BOUND, a, timeout);
+						return a;
+					}
+					if (lower[j] >= window_b[j]){
+						store_chance_bound(key, depth, BoundType::LOWER_BOUND, b, timeout);
+						return b;
+					}
+				}
+
+				split_point point;
+
+				init_split_point(point, StateNodeType::CHANCE_NODE, a, b, depth, timeout);
+				point.probability = probability;
+				point.lower = lower;
+				point.upper = upper;
+				point.window_a = window_a;
+				point.window_b = window_b;
+				split(point, search_children, i + 1, timeout);
+
+				if (point.fail_low){
+					store_chance_bound(key, depth, BoundType::UPPER_BOUND, a, timeout);
+					return a;
+				}
+				if (point.fail_high){
+					store_chance_bound(key, depth, BoundType::LOWER_BOUND, b, timeout);
+					return b;
+				}
+
+				utility += point.utility;
+				break;
+			}
+		}
+
+		utility_type result = static_cast<utility_type>(std::floor(utility + 0.5));
+
+		store_chance_bound(key, depth, BoundType::EXACT, result, timeout);
+
+		return result;
+	}
+
+	// The lower end of a child window of the Star1/Star2 pruning. It is rounded down so that a child value at
+	// the lower end is still a proof that the chance node is at most a.
+	static utility_type child_window_lower(double window_a, utility_type lower){
+		return window_a <= lower ? lower : static_cast<utility_type>(std::floor(window_a));
+	}
 
-		typedef typename std::list<std::tuple<action_type,state_type,double> >::iterator iterator;
+	// The upper end of a child window (rounded up, see child_window_lower())
+	static utility_type child_window_upper(double window_b, utility_type upper){
+		return window_b >= upper ? upper : static_cast<utility_type>(std::ceil(window_b));
+	}
 
-		utility_type utility = 0;
+	// Searches only the first action of the state (the best action of the transposition table if there is one)
+	// with the (a,b) window. Returns false if the state has no actions.
+	bool probe_first_action(state_type& state, utility_type a, utility_type b, int depth, timeout_cutoff& timeout, utility_type& value){
+		transposition_entry entry;
+		bool found = table->probe(gtraits::hash(state), entry);
 
-		for (iterator first = actions.begin(), last = actions.end(); first != last; ++first){
-			utility_type current_utility = exp_minimax_value(std::get<1>(*first), a, b, depth - 1, timeout);
+		successor_generator_type children(state, successors, action_order, (found && entry.has_action) ? &entry.action : 0, 1, &heuristics, ply_of(depth));
 
-			utility += current_utility*std::get<2>(*first);
+		if (!children.next()){
+			return false;
 		}
 
-		return utility;
+		value = exp_minimax_value(children.state(), a, b, depth - 1, timeout);
+		return true;
+	}
+
+	void store_chance_bound(std::uint64_t key, int depth, BoundType bound, utility_type value, timeout_cutoff& timeout){
+		if (!timeout()){
+			table->store(key, depth, bound, value, 0);
+		}
 	}
 };
 
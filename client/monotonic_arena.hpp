@@ -0,0 +1,188 @@
+/*
+ * monotonic_arena.hpp
+ *
+ *  Created on: May 28, 2013
+ *      Author: croatoan
+ */
+
+#ifndef MONOTONIC_ARENA_HPP_
+#define MONOTONIC_ARENA_HPP_
+
+#include<cstddef>
+#include<cstdlib>
+#include<new>
+#include<vector>
+
+namespace search{
+
+/**
+ * A monotonic arena hands out memory by bumping a pointer inside big blocks and never frees single
+ * allocations. All of its memory is released at once by reset(), which takes constant time: the blocks are kept
+ * and reused by the next allocations, so after the first few searches the arena doesn't call malloc at all.
+ *
+ * The arena a thread allocates from is chosen with an arena_scope, and the arena_allocator (which can be plugged
+ * into the standard containers) takes its memory from the arena of the scope it was created in.
+ */
+class monotonic_arena{
+public:
+	// the size of each block in bytes
+	static const std::size_t block_size = 1 << 20;
+
+	monotonic_arena() : current(0), offset(0){}
+
+	monotonic_arena(const monotonic_arena&) = delete;
+	monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+	~monotonic_arena(){
+		for (std::size_t i = 0; i < blocks.size(); ++i){
+			std::free(blocks[i].memory);
+		}
+	}
+
+	// Returns memory for the given number of bytes aligned at the given alignment
+	void* allocate(std::size_t bytes, std::size_t alignment){
+		for (;;){
+			if (current < blocks.size()){
+				block& b = blocks[current];
+				std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+
+				if (start + bytes <= b.size){
+					offset = start + bytes;
+					return b.memory + start;
+				}
+
+				// this block is full, move on to the next one
+				++current;
+				offset = 0;
+				continue;
+			}
+
+			// all the blocks are full so we need a new one (big enough for the allocation)
+			block b;
+
+			b.size = bytes + alignment > block_size ? bytes + alignment : block_size;
+			b.memory = static_cast<char*>(std::malloc(b.size));
+
+			if (b.memory == 0){
+				throw std::bad_alloc();
+			}
+
+			blocks.push_back(b);
+		}
+	}
+
+	// A point in the allocations of the arena to rewind to
+	struct mark{
+		std::size_t current;
+		std::size_t offset;
+	};
+
+	mark position() const{
+		mark m;
+
+		m.current = current;
+		m.offset = offset;
+		return m;
+	}
+
+	// Releases the memory handed out by the arena since the given mark was taken
+	void rewind(const mark& m){
+		current = m.current;
+		offset = m.offset;
+	}
+
+	// Releases all the memory handed out by the arena
+	void reset(){
+		current = 0;
+		offset = 0;
+	}
+
+	// The arena of the innermost arena_scope of the calling thread (null if there is none)
+	static monotonic_arena*& active(){
+		static thread_local monotonic_arena* arena = 0;
+		return arena;
+	}
+private:
+	struct block{
+		char* memory;
+		std::size_t size;
+	};
+
+	std::vector<block> blocks;
+	std::size_t current; // the block allocations are made from
+	std::size_t offset; // the first free byte of the current block
+};
+
+// Makes the given arena the one the calling thread allocates from for the lifetime of the scope. When the scope
+// ends the arena is reset (or, if it was already active when the scope began, rewound to where it was then)
+// and the previous one is restored.
+class arena_scope{
+public:
+	explicit arena_scope(monotonic_arena& _arena) : arena(_arena), previous(monotonic_arena::active()), start(_arena.position()){
+		monotonic_arena::active() = &arena;
+	}
+
+	arena_scope(const arena_scope&) = delete;
+	arena_scope& operator=(const arena_scope&) = delete;
+
+	~arena_scope(){
+		monotonic_arena::active() = previous;
+
+		if (previous != &arena){
+			arena.reset();
+		}
+		else{
+			arena.rewind(start);
+		}
+	}
+private:
+	monotonic_arena& arena;
+	monotonic_arena* previous;
+	monotonic_arena::mark start;
+};
+
+// An allocator for the standard containers that takes its memory from the arena active when it was created,
+// or from operator new if there was none. Deallocation is a no-op in the first case.
+template<class T>
+class arena_allocator{
+public:
+	typedef T value_type;
+
+	template<class U> struct rebind{
+		typedef arena_allocator<U> other;
+	};
+
+	arena_allocator() : arena(monotonic_arena::active()){}
+
+	template<class U>
+	arena_allocator(const arena_allocator<U>& other) : arena(other.arena){}
+
+	T* allocate(std::size_t n){
+		if (arena != 0){
+			return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T)));
+		}
+		return static_cast<T*>(::operator new(n*sizeof(T)));
+	}
+
+	void deallocate(T* p, std::size_t){
+		if (arena == 0){
+			::operator delete(p);
+		}
+	}
+
+	template<class U>
+	bool operator==(const arena_allocator<U>& other) const{
+		return arena == other.arena;
+	}
+
+	template<class U>
+	bool operator!=(const arena_allocator<U>& other) const{
+		return arena != other.arena;
+	}
+
+	monotonic_arena* arena;
+};
+
+} // namespace search
+
+#endif /* MONOTONIC_ARENA_HPP_ */
@@ -9,6 +9,9 @@
 #include<chrono>
 #include<list>
 #include<limits>
+#include<cstdlib>
+#include<new>
+#include<vector>
 #include"time_limit_cutoff_test.hpp"
 #include"tucants_all.hpp"
 #include"tucants_game.hpp"
@@ -41,6 +44,36 @@ void print_move(const Move& move){
 	}
 }
 
+// Makes a fixed set of positions by playing random legal moves from the starting position
+std::vector<tucants_game> fixed_positions(int num_positions){
+	std::vector<tucants_game> positions;
+
+	for (int game = 0; static_cast<int>(positions.size()) < num_positions; ++game){
+		srand(1234 + game);
+
+		Position pos;
+		initPosition(&pos);
+
+		for (int ply = 0; ply < 60 && static_cast<int>(positions.size()) < num_positions && canMove(&pos, pos.turn); ++ply){
+			if (ply%3 == 0){
+				tucants_game gamePosition;
+				gamePosition.init();
+				gamePosition.pos = pos;
+				gamePosition.player = pos.turn;
+				positions.push_back(gamePosition);
+			}
+
+			tucants_move_list moves;
+			bitboard_moves(to_bitboard(pos), pos.turn, std::back_inserter(moves));
+
+			Move move = moves[rand()%moves.size()];
+			doMove(&pos, &move);
+		}
+	}
+
+	return positions;
+}
+
 #if 0
 int main(){
 	// Purpose:
@@ -85,3 +118,438 @@ int main(){
 #endif
 
 
+
+#if 0
+// Counts every allocation made through operator new
+static unsigned long num_allocations = 0;
+
+void* operator new(std::size_t size){
+	++num_allocations;
+
+	void* p = std::malloc(size);
+
+	if (p == 0){
+		throw std::bad_alloc();
+	}
+
+	return p;
+}
+
+void operator delete(void* p) noexcept{
+	std::free(p);
+}
+
+// Runs a search up to the given depth with the given game traits and returns the number of allocations it made
+template<class Game>
+unsigned long allocations_per_search(const tucants_game& gamePosition, int depth){
+	tucants_game_cutoff cutoff;
+	search::iterative_deepening_alpha_beta_expectiminimax<Game> minimax(cutoff);
+
+	// we do not a time limit so we implicitly specify a very large number of milliseconds as timeout
+	timeout_cutoff timeout(std::numeric_limits<unsigned int>::max());
+
+	unsigned long before = num_allocations;
+
+	minimax.decision_up_to_depth(gamePosition, depth, timeout);
+
+	return num_allocations - before;
+}
+
+int main(){
+	// Purpose:
+	// Count the heap allocations of a search with the successor lists and of a search with make and undo
+
+	tucants_game gamePosition;
+	gamePosition.player = BLACK;
+	gamePosition.init();
+	initPosition(&gamePosition.pos);
+
+	for (int depth = 1; depth <= 6; ++depth){
+		std::cout << "Up to depth = " << depth << " allocations with lists: " << allocations_per_search<tucants_list>(gamePosition, depth);
+		std::cout << " with make and undo: " << allocations_per_search<tucants>(gamePosition, depth) << std::endl;
+	}
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+int main(){
+	// Purpose:
+	// Time the Young Brothers Wait search with increasing numbers of threads against the single threaded one
+	// on a fixed set of positions. Each position is searched with iterative deepening up to the same depth.
+
+	const int num_positions = 50;
+	const int depth = 6;
+
+	std::vector<tucants_game> positions = fixed_positions(num_positions);
+	std::vector<Move> single_threaded_moves;
+	double single_threaded_time = 0;
+
+	for (unsigned int threads = 1; threads <= 8; threads *= 2){
+		tucants_game_cutoff cutoff;
+		search::iterative_deepening_alpha_beta_expectiminimax<tucants> minimax(cutoff);
+		minimax.set_split_threads(threads);
+
+		double time = 0;
+		int same_moves = 0;
+
+		for (std::size_t i = 0; i < positions.size(); ++i){
+			// we do not a time limit so we implicitly specify a very large number of milliseconds as timeout
+			timeout_cutoff timeout(std::numeric_limits<unsigned int>::max());
+			Move move;
+
+			auto start = std::chrono::steady_clock::now();
+
+			for (int d = 0; d <= depth; ++d){
+				move = minimax.decision_up_to_depth(positions[i], d, timeout);
+			}
+
+			time += std::chrono::duration <double,  std::milli> (std::chrono::steady_clock::now() - start).count();
+
+			if (threads == 1){
+				single_threaded_moves.push_back(move);
+			}
+			else if (move == single_threaded_moves[i]){
+				++same_moves;
+			}
+		}
+
+		if (threads == 1){
+			single_threaded_time = time;
+		}
+
+		std::cout << "Threads = " << threads << " time per position: " << time/positions.size() << " ms speedup: " << single_threaded_time/time;
+		std::cout << " same move as with one thread: " << (threads == 1 ? positions.size() : same_moves) << "/" << positions.size() << std::endl;
+	}
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+int main(){
+	// Purpose:
+	// Check that the decisions meet their deadline: the histogram of how late each decision returns after its
+	// time is up, for a few times per move and numbers of threads. The time management is turned off so that
+	// every decision runs until the timeout.
+
+	const int num_positions = 100;
+	const unsigned int times[] = {10, 50, 200};
+	const unsigned int threads[] = {1, 4};
+
+	// the upper ends of the buckets in milliseconds (the last bucket has none)
+	const double buckets[] = {0.1, 0.25, 0.5, 1, 2, 5};
+	const int num_buckets = sizeof(buckets)/sizeof(buckets[0]) + 1;
+
+	std::vector<tucants_game> positions = fixed_positions(num_positions);
+
+	for (unsigned int t : threads){
+		for (unsigned int msec : times){
+			tucants_game_cutoff cutoff;
+			search::iterative_deepening_alpha_beta_expectiminimax<tucants> minimax(cutoff);
+			minimax.set_split_threads(t);
+			minimax.set_time_management(false);
+
+			int histogram[num_buckets] = {0};
+			double worst = 0;
+
+			for (std::size_t i = 0; i < positions.size(); ++i){
+				minimax.new_game();
+
+				auto start = std::chrono::steady_clock::now();
+
+				minimax.decision(positions[i], msec);
+
+				double overshoot = std::chrono::duration <double,  std::milli> (std::chrono::steady_clock::now() - start).count() - msec;
+				int bucket = 0;
+
+				while (bucket < num_buckets - 1 && overshoot >= buckets[bucket]){
+					++bucket;
+				}
+
+				++histogram[bucket];
+				worst = std::max(worst, overshoot);
+			}
+
+			std::cout << "Threads = " << t << " time = " << msec << " ms overshoot:";
+
+			for (int bucket = 0; bucket < num_buckets; ++bucket){
+				if (bucket < num_buckets - 1){
+					std::cout << " <" << buckets[bucket] << ": " << histogram[bucket];
+				}
+				else{
+					std::cout << " more: " << histogram[bucket];
+				}
+			}
+
+			std::cout << " worst: " << worst << " ms" << std::endl;
+		}
+	}
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+// Makes a position with ants and food scattered at random on the cells of the board, denser than in real games so
+// that long capture chains are common
+tucants_game random_position(){
+	tucants_game gamePosition;
+	gamePosition.init();
+	initPosition(&gamePosition.pos);
+
+	for (int i = 0; i < BOARD_ROWS; ++i){
+		for (int j = (i + 1)%2; j < BOARD_COLUMNS; j += 2){
+			int r = rand()%8;
+
+			gamePosition.pos.board[i][j] = r < 3 ? WHITE : (r < 6 ? BLACK : (r < 7 ? RTILE : EMPTY));
+		}
+	}
+
+	gamePosition.pos.turn = rand()%2;
+	gamePosition.player = rand()%2;
+	tucants_rehash(gamePosition);
+
+	return gamePosition;
+}
+
+int main(){
+	// Purpose:
+	// Check the evaluation on the bitboards (the incremental terms and the bitboard mobility) against the
+	// evaluation computed from the board alone, on the positions of random games and on random boards
+
+	std::vector<tucants_game> positions = fixed_positions(2000);
+
+	srand(1);
+
+	for (int i = 0; i < 100000; ++i){
+		positions.push_back(random_position());
+	}
+
+	int differences = 0;
+
+	for (std::size_t i = 0; i < positions.size(); ++i){
+		tucants_game& gamePosition = positions[i];
+		tucants_rehash(gamePosition);
+
+		for (int color = 0; color < 2; ++color){
+			if (player_utility(gamePosition, color) != full_player_utility(gamePosition, color)){
+				if (++differences <= 10){
+					std::cout << "Position " << i << " color " << color << " utility " << player_utility(gamePosition, color) << " instead of " << full_player_utility(gamePosition, color) << std::endl;
+				}
+			}
+		}
+	}
+
+	std::cout << "Positions: " << positions.size() << " differences: " << differences << std::endl;
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+// The mobility part of the evaluation at every leaf the search evaluates, for the max nodes and for the min nodes
+static std::vector<int> mobility_differences[2];
+
+// The evaluation of tucants that records the mobility part of each evaluation
+struct recording_evaluation_function{
+	int operator()(const tucants_game& game) const{
+		int difference = player_mobility(game, game.player) - player_mobility(game, 1 - game.player);
+
+		mobility_differences[game.pos.turn == game.player ? 0 : 1].push_back(difference);
+
+		return tucants_evaluation_function()(game);
+	}
+};
+
+struct tucants_recording : tucants{
+	typedef recording_evaluation_function evaluation_function_type;
+};
+
+int main(){
+	// Purpose:
+	// Calibrate the margins of the lazy evaluation (see tucants::evaluation_bounds()): the quantiles of the
+	// mobility part of the evaluation (the part the lazy evaluation leaves out) over the leaves of searches of
+	// a fixed set of positions, at the max and at the min nodes
+
+	const int num_positions = 200;
+	const int depth = 6;
+
+	std::vector<tucants_game> positions = fixed_positions(num_positions);
+
+	for (std::size_t i = 0; i < positions.size(); ++i){
+		tucants_game_cutoff cutoff;
+		search::iterative_deepening_alpha_beta_expectiminimax<tucants_recording> minimax(cutoff);
+
+		// we do not a time limit so we implicitly specify a very large number of milliseconds as timeout
+		timeout_cutoff timeout(std::numeric_limits<unsigned int>::max());
+
+		for (int d = 0; d <= depth; ++d){
+			minimax.decision_up_to_depth(positions[i], d, timeout);
+		}
+	}
+
+	const double quantiles[] = {0, 0.001, 0.01, 0.5, 0.99, 0.999, 1};
+
+	for (int node = 0; node < 2; ++node){
+		std::vector<int>& differences = mobility_differences[node];
+
+		std::sort(differences.begin(), differences.end());
+
+		std::cout << (node == 0 ? "Max" : "Min") << " nodes: " << differences.size() << " leaves, quantiles:";
+
+		for (double q : quantiles){
+			std::cout << " " << q << ": " << differences[static_cast<std::size_t>(q*(differences.size() - 1))];
+		}
+
+		std::cout << std::endl;
+	}
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+int main(){
+	// Purpose:
+	// Size the evaluation cache: the hit rate and the time of searches of a fixed set of positions with caches of
+	// a few sizes (and with none), which must all decide the same actions
+
+	const int num_positions = 100;
+	const int depth = 7;
+	const std::size_t sizes[] = {0, 1, 4, 16};
+
+	std::vector<tucants_game> positions = fixed_positions(num_positions);
+	std::vector<Move> decisions;
+
+	for (std::size_t size : sizes){
+		search::evaluation_cache_statistics statistics;
+		double milliseconds = 0;
+		int differences = 0;
+
+		for (std::size_t i = 0; i < positions.size(); ++i){
+			tucants_game_cutoff cutoff;
+			search::iterative_deepening_alpha_beta_expectiminimax<tucants> minimax(cutoff, 16, size);
+			Move action;
+
+			// we do not a time limit so we implicitly specify a very large number of milliseconds as timeout
+			timeout_cutoff timeout(std::numeric_limits<unsigned int>::max());
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			// each decision counts its own probes
+			for (int d = 0; d <= depth; ++d){
+				action = minimax.decision_up_to_depth(positions[i], d, timeout);
+				statistics += minimax.evaluation_statistics();
+			}
+
+			milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (size == 0){
+				decisions.push_back(action);
+			}
+			else if (!(action == decisions[i])){
+				++differences;
+			}
+		}
+
+		std::cout << "Cache of " << size << " MB: " << milliseconds/positions.size() << " ms per position, hits " << 100.0*statistics.hit_rate() << "% of " << statistics.probes << " probes, " << differences << " different decisions" << std::endl;
+	}
+
+	return (0);
+}
+#endif
+
+
+
+#if 0
+int main(){
+	// Purpose:
+	// Check that each outcome of a chance node scores the same after the search has walked the subtree of an
+	// outcome before it (with moves that land on food, which are chance nodes themselves) and undone it, as it
+	// does on a fresh copy of the chance node
+
+	std::vector<tucants_game> positions = fixed_positions(2000);
+
+	int chance_nodes = 0;
+	int nested_chance_nodes = 0;
+	int differences = 0;
+
+	for (std::size_t i = 0; i < positions.size(); ++i){
+		tucants_game gamePosition = positions[i];
+		tucants_rehash(gamePosition);
+
+		tucants_move_list moves;
+		tucants_moves(gamePosition, std::back_inserter(moves));
+
+		for (const Move& move : moves){
+			if (food_cells_landed(gamePosition, move) == 0){
+				continue;
+			}
+
+			tucants_game chance = gamePosition;
+			tucants_undo undo;
+			tucants_apply(chance, move, undo);
+			++chance_nodes;
+
+			std::vector<std::pair<tucants_outcome, double> > outcomes;
+			tucants_outcomes(chance, std::back_inserter(outcomes));
+
+			// the outcomes on fresh copies of the chance node
+			std::vector<tucants_game> fresh_outcomes(outcomes.size(), chance);
+
+			for (std::size_t k = 0; k < outcomes.size(); ++k){
+				tucants_undo fresh_undo;
+				tucants_apply_outcome(fresh_outcomes[k], outcomes[k].first, fresh_undo);
+			}
+
+			for (std::size_t k = 0; k < outcomes.size(); ++k){
+				const tucants_game& fresh = fresh_outcomes[k];
+
+				// walk the children of another outcome first, the ones landing on food too, as the search does
+				// before it gets to this outcome
+				tucants_undo outcome_undo;
+				tucants_apply_outcome(chance, outcomes[(k + 1)%outcomes.size()].first, outcome_undo);
+
+				tucants_move_list children;
+				tucants_moves(chance, std::back_inserter(children));
+
+				for (const Move& child : children){
+					tucants_undo child_undo;
+
+					nested_chance_nodes += food_cells_landed(chance, child) != 0;
+					tucants_apply(chance, child, child_undo);
+					tucants_undo_move(chance, child_undo);
+				}
+
+				tucants_undo_move(chance, outcome_undo);
+
+				tucants_apply_outcome(chance, outcomes[k].first, outcome_undo);
+
+				if (chance.key != fresh.key || chance.pos.score[WHITE] != fresh.pos.score[WHITE] || chance.pos.score[BLACK] != fresh.pos.score[BLACK]){
+					if (++differences <= 10){
+						std::cout << "Position " << i << " outcome " << k << " scores W " << (int)chance.pos.score[WHITE] << " B " << (int)chance.pos.score[BLACK] << " instead of W " << (int)fresh.pos.score[WHITE] << " B " << (int)fresh.pos.score[BLACK] << std::endl;
+					}
+				}
+
+				tucants_undo_move(chance, outcome_undo);
+			}
+		}
+	}
+
+	std::cout << "Chance nodes: " << chance_nodes << " nested chance nodes: " << nested_chance_nodes << " differences: " << differences << std::endl;
+
+	return (0);
+}
+#endif
@@ -10,6 +10,7 @@
 
 #include<iostream>
 #include<chrono>
+#include<atomic>
 
 
 	using std::chrono::steady_clock;
@@ -19,12 +20,30 @@
 	 * timeout_cutoff is used to determine a timeout that is defined as the number of milliseconds that can pass
 	 * starting from "now", where now is defined as the point where the constructor is called with the given
 	 * number of arguments.
+	 *
+	 * The timeout can also be given a flag that another thread sets to end it before the time limit.
+	 *
+	 * The search asks for the timeout at every node, far too often to read the clock each time. The flag is read
+	 * at every call but the clock only once every so many calls, and the number of calls between two readings
+	 * is calibrated as the timeout goes so that the clock is read about every poll_period. The time limit is
+	 * thus noticed at most a couple of poll periods late.
 	 */
 	class timeout_cutoff{
 	public:
 		typedef steady_clock::time_point time_point;
 
-		explicit timeout_cutoff(unsigned int milliseconds) : limit(steady_clock::now() + std::chrono::milliseconds(milliseconds)), passed(false), num_milliseconds(milliseconds){}
+		// how often the clock is meant to be read
+		static constexpr std::chrono::microseconds::rep poll_period = 100;
+
+		// the most calls between two readings of the clock
+		static const unsigned int max_interval = 1 << 16;
+
+		explicit timeout_cutoff(unsigned int milliseconds) : timeout_cutoff(steady_clock::now(), milliseconds, 0){}
+
+		timeout_cutoff(unsigned int milliseconds, const std::atomic<bool>& _stop) : timeout_cutoff(steady_clock::now(), milliseconds, &_stop){}
+
+		// a timeout ending at the same time limit as another one (or when the flag is set)
+		timeout_cutoff(time_point _limit, const std::atomic<bool>& _stop) : limit(_limit), passed(false), num_milliseconds(0), stop(&_stop), last_poll(steady_clock::now()), interval(1), calls(0){}
 
 		// this little utility is non-copyable
 		timeout_cutoff(const timeout_cutoff&) = delete;
@@ -34,18 +53,55 @@
 			if (passed){
 				return true;
 			}
-			return passed = (steady_clock::now() >= limit);
+			if (stop != 0 && stop->load(std::memory_order_relaxed)){
+				return passed = true;
+			}
+			if (++calls < interval){
+				return false;
+			}
+			calls = 0;
+
+			time_point now = steady_clock::now();
+
+			calibrate(now);
+
+			return passed = (now >= limit);
 		}
 
 		unsigned int milliseconds() const{
 			return num_milliseconds;
 		}
+
+		time_point time_limit() const{
+			return limit;
+		}
 	private:
+		timeout_cutoff(time_point now, unsigned int milliseconds, const std::atomic<bool>* _stop) : limit(now + std::chrono::milliseconds(milliseconds)), passed(false), num_milliseconds(milliseconds), stop(_stop), last_poll(now), interval(1), calls(0){}
+
+		// Doubles the calls between two readings of the clock if the last ones came much sooner than the poll
+		// period and halves them if they came much later
+		void calibrate(time_point now) const{
+			std::chrono::microseconds::rep period = std::chrono::duration_cast<std::chrono::microseconds>(now - last_poll).count();
+
+			last_poll = now;
+
+			if (2*period < poll_period && interval < max_interval){
+				interval *= 2;
+			}
+			else if (period > 2*poll_period && interval > 1){
+				interval /= 2;
+			}
+		}
+
 		time_point limit; // a time point indicating the time limit for the timeout
 		mutable bool passed; // whether the limit is passed. initialized to false
 					// it is set to true when the time limit is exhausted.
 					// it is used to avoid making calls to time functions
 		unsigned int num_milliseconds;
+		const std::atomic<bool>* stop; // the flag that ends the timeout early (null if there is none)
+		mutable time_point last_poll; // when the clock was last read
+		mutable unsigned int interval; // the calls between two readings of the clock
+		mutable unsigned int calls; // the calls since the clock was last read
 	};
 
 
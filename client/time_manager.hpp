@@ -0,0 +1,139 @@
+/*
+ * time_manager.hpp
+ *
+ *  Created on: Jun 3, 2013
+ *      Author: croatoan
+ */
+
+#ifndef TIME_MANAGER_HPP_
+#define TIME_MANAGER_HPP_
+
+#include<chrono>
+#include<cstddef>
+
+namespace search{
+
+/**
+ * Decides how much of the time of a decision the iterative deepening spends. The time given to a decision is a
+ * hard ceiling, which the timeout of the search enforces. Within it the manager keeps a soft target: no
+ * iteration starts once the target is passed, nor one that is predicted not to finish before the ceiling (it
+ * would be cut off with little to show for it).
+ *
+ * The time an iteration takes is predicted from the time of the iteration before it and the effective
+ * branching factor, the ratio of the times of consecutive iterations. The branching factor is averaged over
+ * the iterations of all the decisions, so that the first iterations of a decision are predicted too.
+ *
+ * The target is a share of the ceiling that depends on how settled the search looks: it grows when the best
+ * action changes or the value swings from one iteration to the next (a volatile position that deserves a
+ * deeper look) and shrinks while the best action stays the same. A decision with a single action is made as
+ * soon as the first iteration finishes.
+ */
+class time_manager{
+public:
+	typedef std::chrono::steady_clock clock;
+
+	// the share of the ceiling the target starts from, and the least and the most it can be
+	static constexpr double default_share = 0.5;
+	static constexpr double min_share = 0.25;
+	static constexpr double max_share = 1.0;
+
+	time_manager() : share(default_share), branching(initial_branching), enabled(true){}
+
+	// Whether the manager is used at all (otherwise each decision deepens until the ceiling)
+	void enable(bool _enabled){
+		enabled = _enabled;
+	}
+
+	bool is_enabled() const{
+		return enabled;
+	}
+
+	// Starts a decision with the given ceiling in milliseconds
+	void start(unsigned int milliseconds){
+		start_time = clock::now();
+		last_time = start_time;
+		last_duration = 0.0;
+		ceiling = milliseconds;
+		share = default_share;
+		stable_iterations = 0;
+	}
+
+	// Records the end of an iteration. best_changed tells whether it changed the best action of the iteration
+	// before it and swing whether its value moved farther than expected.
+	void iteration_done(bool best_changed, bool swing){
+		clock::time_point now = clock::now();
+		double duration = std::chrono::duration<double, std::milli>(now - last_time).count();
+
+		// the very short iterations say little about the branching (the clock and the overhead dominate)
+		if (last_duration >= min_measured && duration >= min_measured){
+			double ratio = duration/last_duration;
+
+			ratio = ratio < 1.0 ? 1.0 : (ratio > max_branching ? max_branching : ratio);
+
+			branching += branching_weight*(ratio - branching);
+		}
+
+		last_time = now;
+		last_duration = duration;
+
+		if (best_changed || swing){
+			share *= best_changed ? 1.5 : 1.25;
+			share = share > max_share ? max_share : share;
+			stable_iterations = 0;
+		}
+		else if (++stable_iterations >= 3){
+			share *= 0.9;
+			share = share < min_share ? min_share : share;
+		}
+	}
+
+	// Whether the next iteration is worth starting, given the number of actions of the root
+	bool next_iteration(std::size_t num_actions) const{
+		if (!enabled){
+			return true;
+		}
+
+		if (num_actions == 1){
+			return false;
+		}
+
+		double elapsed = std::chrono::duration<double, std::milli>(clock::now() - start_time).count();
+
+		if (elapsed >= share*ceiling){
+			return false;
+		}
+
+		return elapsed + predicted() <= ceiling;
+	}
+
+	// the predicted time of the next iteration in milliseconds
+	double predicted() const{
+		return last_duration*branching;
+	}
+
+	// the effective branching factor
+	double branching_factor() const{
+		return branching;
+	}
+private:
+	// the branching factor assumed before any is measured and the most any iteration is taken to show
+	static constexpr double initial_branching = 4.0;
+	static constexpr double max_branching = 32.0;
+	// the weight of each new ratio in the average of the branching factor
+	static constexpr double branching_weight = 0.25;
+	// the shortest iteration (in milliseconds) measured
+	static constexpr double min_measured = 0.5;
+
+	clock::time_point start_time;
+	clock::time_point last_time; // when the last iteration finished
+	double last_duration; // how long the last iteration took in milliseconds
+	unsigned int ceiling;
+	double share; // the share of the ceiling that is the target
+	int stable_iterations; // the iterations in a row that kept the best action
+	double branching;
+	bool enabled;
+};
+
+} // namespace search
+
+#endif /* TIME_MANAGER_HPP_ */
@@ -0,0 +1,184 @@
+/*
+ * transposition_table.hpp
+ *
+ *  Created on: May 21, 2013
+ *      Author: croatoan
+ */
+
+#ifndef TRANSPOSITION_TABLE_HPP_
+#define TRANSPOSITION_TABLE_HPP_
+
+#include<atomic>
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<memory>
+#include<type_traits>
+
+namespace search{
+
+// The kind of value stored in a transposition table entry. An exact value is the minimax value of the state
+// searched at the stored depth. A lower bound comes from a cutoff at a max node (the true value is at least
+// the stored one) and an upper bound from a cutoff at a min node or a max node that never raised alpha.
+enum class BoundType {EXACT, LOWER_BOUND, UPPER_BOUND};
+
+/**
+ * A fixed size transposition table keyed by the hash of the states. The table is direct mapped: each key maps
+ * to exactly one slot (the low bits of the key) and the full key is kept in the slot to detect collisions.
+ * When two states map to the same slot the entry searched to the greater depth is kept, unless the new entry
+ * is for the same state in which case it always replaces the old one.
+ *
+ * The table can be kept from one search to the next. Each search is a new generation of the table (see
+ * new_search()) and the entries of the earlier generations are still found by the probes but they age: any
+ * entry of the current search replaces them, however deep they were searched.
+ *
+ * The table can be shared by threads searching at the same time without any locking. The data of an entry is
+ * packed in a few words and the slot keeps the key XORed with all of them (instead of the plain key), so an entry whose words were written
+ * by two threads at once (or read while being written) doesn't verify against the key and is taken as a miss.
+ *
+ * Action : the type of the best action stored along with the value
+ * Utility : the type of the values stored
+ * Both must be trivially copyable, since the entries are copied in and out of the slots bytewise.
+ */
+template<class Action, class Utility>
+class transposition_table{
+public:
+	struct entry{
+		Action action; // the best action found for the state (valid only if has_action is true)
+		Utility value; // the value (or bound) of the state
+		int depth; // the remaining depth the state was searched with
+		BoundType bound; // the kind of value stored
+		bool has_action; // whether action holds a best action
+		bool used; // whether the slot has ever been written
+		unsigned char generation; // the search that stored the entry
+	};
+
+	static_assert(std::is_trivially_copyable<entry>::value, "transposition_table: the actions and the utility values must be trivially copyable");
+
+	// constructs a table taking up (at most) the given number of megabytes. The number of entries is always a
+	// power of two so that the slot of a key can be found with a mask.
+	explicit transposition_table(std::size_t megabytes){
+		std::size_t bytes = megabytes*1024*1024;
+		std::size_t num_entries = 1;
+
+		while (num_entries*2*sizeof(slot) <= bytes){
+			num_entries *= 2;
+		}
+
+		table.reset(new slot[num_entries]);
+		num_slots = num_entries;
+		mask = num_entries - 1;
+		generation = 0;
+		clear();
+	}
+
+	transposition_table(const transposition_table&) = delete;
+	transposition_table& operator=(const transposition_table&) = delete;
+
+	// Looks up the state with the given key. Returns true and fills in e if the state is found.
+	bool probe(std::uint64_t key, entry& e) const{
+		std::uint64_t words[num_words];
+
+		if (!load(table[key & mask], key, words)){
+			return false;
+		}
+
+		std::memcpy(&e, words, sizeof(entry));
+
+		return e.used;
+	}
+
+	// Stores the result of searching the state with the given key. action may be null if no best action is known.
+	void store(std::uint64_t key, int depth, BoundType bound, Utility value, const Action* action){
+		slot& s = table[key & mask];
+		std::uint64_t words[num_words];
+		entry old;
+		bool same = load(s, key, words);
+
+		std::memcpy(&old, words, sizeof(entry));
+
+		// keep the deeper entry of a different state, unless it is left from an earlier search
+		if (!same && old.used && old.generation == generation && old.depth > depth){
+			return;
+		}
+
+		// do not forget the best action of the same state when the new result does not know one
+		if (action == 0 && same && old.used && old.has_action){
+			action = &old.action;
+		}
+
+		entry e = entry();
+
+		if (action != 0){
+			e.action = *action;
+		}
+		e.has_action = (action != 0);
+		e.value = value;
+		e.depth = depth;
+		e.bound = bound;
+		e.used = true;
+		e.generation = generation;
+
+		std::memset(words, 0, sizeof(words));
+		std::memcpy(words, &e, sizeof(entry));
+
+		std::uint64_t check = key;
+
+		for (std::size_t i = 0; i < num_words; ++i){
+			s.data[i].store(words[i], std::memory_order_relaxed);
+			check ^= words[i];
+		}
+		s.check.store(check, std::memory_order_relaxed);
+	}
+
+	// Starts a new generation of the table, making the entries stored so far stale (it must not be in use by
+	// any search)
+	void new_search(){
+		++generation;
+	}
+
+	// empties the table (it must not be in use by any search)
+	void clear(){
+		for (std::size_t i = 0; i < num_slots; ++i){
+			for (std::size_t j = 0; j < num_words; ++j){
+				table[i].data[j].store(0, std::memory_order_relaxed);
+			}
+			table[i].check.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	// the number of entries in the table
+	std::size_t size() const{
+		return num_slots;
+	}
+private:
+	// the number of words an entry is packed in
+	static const std::size_t num_words = (sizeof(entry) + sizeof(std::uint64_t) - 1)/sizeof(std::uint64_t);
+
+	struct slot{
+		std::atomic<std::uint64_t> check; // the key XORed with the words of data
+		std::atomic<std::uint64_t> data[num_words];
+	};
+
+	// Reads the words of the slot. Returns whether they are a consistent entry of the state with the given key
+	// (the words are read either way, an empty slot reads as an unused entry).
+	static bool load(const slot& s, std::uint64_t key, std::uint64_t (&words)[num_words]){
+		std::uint64_t check = s.check.load(std::memory_order_relaxed);
+
+		for (std::size_t i = 0; i < num_words; ++i){
+			words[i] = s.data[i].load(std::memory_order_relaxed);
+			check ^= words[i];
+		}
+
+		return check == key;
+	}
+
+	std::unique_ptr<slot[]> table;
+	std::size_t num_slots;
+	std::size_t mask;
+	unsigned char generation; // the generation of the current search (it wraps around)
+};
+
+} // namespace search
+
+#endif /* TRANSPOSITION_TABLE_HPP_ */
@@ -22,6 +22,8 @@
     #define assert(p) {}
 #endif
 
+//#define _DEBUG_HASH_	//uncomment this line to check every incrementally updated hash key against a full recomputation
+
 
 #ifndef getOtherSide
 	#define getOtherSide( a ) ( 1-(a) )
@@ -0,0 +1,427 @@
+/*
+ * tucants_bitboard.hpp
+ *
+ *  Created on: May 24, 2013
+ *      Author: croatoan
+ */
+
+#ifndef TUCANTS_BITBOARD_HPP_
+#define TUCANTS_BITBOARD_HPP_
+
+/**
+ * Bitboard representation of the tucants board and move generation on top of it.
+ *
+ * Only the 48 cells with (i+j) odd can ever be occupied, so a set of cells fits in a 64 bit word. The cells are
+ * numbered row by row, 4 cells per row, and after every second row one unused ("ghost") bit is left out:
+ *
+ * 		row 0  : bits  0- 3		row 1  : bits  4- 7		ghost bit 8
+ * 		row 2  : bits  9-12		row 3  : bits 13-16		ghost bit 17
+ * 		...
+ * 		row 10 : bits 45-48		row 11 : bits 49-52
+ *
+ * With this layout a diagonal step is always the same shift: towards the higher rows (the direction of the white
+ * ants) a shift left by 4 moves one column to the left and a shift left by 5 one column to the right. Towards the
+ * lower rows (the direction of the black ants) a shift right by 5 moves to the left and a shift right by 4 to the
+ * right. Steps that would leave the board from the sides land on a ghost bit and are masked out.
+ */
+
+#include<cstdint>
+#include<cstdlib>
+#include"tucants_all.hpp"
+
+// the set of all the cells of the board
+static const std::uint64_t bitboard_cells = ((1ULL << 53) - 1) & ~((1ULL << 8) | (1ULL << 17) | (1ULL << 26) | (1ULL << 35) | (1ULL << 44));
+
+// The board as sets of cells: the ants of each color and the cells with food
+struct tucants_bitboard{
+	std::uint64_t ants[2]; // indexed by WHITE and BLACK
+	std::uint64_t food;
+
+	// the cells without an ant (a cell with food is empty)
+	std::uint64_t empty() const{
+		return bitboard_cells & ~(ants[WHITE] | ants[BLACK]);
+	}
+
+	bool operator==(const tucants_bitboard& other) const{
+		return ants[WHITE] == other.ants[WHITE] && ants[BLACK] == other.ants[BLACK] && food == other.food;
+	}
+};
+
+// Returns the bit of the (i,j) cell. (i+j) must be odd.
+inline int bitboard_index(int i, int j){
+	return (i/2)*9 + (i%2)*4 + j/2;
+}
+
+// Returns the row of the cell with the given bit
+inline int bitboard_row(int bit){
+	return 2*(bit/9) + (bit%9 >= 4 ? 1 : 0);
+}
+
+// Returns the column of the cell with the given bit
+inline int bitboard_column(int bit){
+	int offset = bit%9;
+
+	return offset < 4 ? 2*offset + 1 : 2*(offset - 4);
+}
+
+// Returns the index of the lowest set bit of a non empty set
+inline int bitboard_first(std::uint64_t set){
+	return __builtin_ctzll(set);
+}
+
+// Moves every cell of the set one diagonal step forward for an ant of the given color. Direction 0 is towards
+// column j-1 and direction 1 towards column j+1 (the same order as move_once()).
+inline std::uint64_t bitboard_forward(std::uint64_t set, char color, int direction){
+	if (color == WHITE){
+		return (set << (direction == 0 ? 4 : 5)) & bitboard_cells;
+	}
+	return (set >> (direction == 0 ? 5 : 4)) & bitboard_cells;
+}
+
+// The inverse of bitboard_forward(): moves every cell one diagonal step back
+inline std::uint64_t bitboard_backward(std::uint64_t set, char color, int direction){
+	if (color == WHITE){
+		return (set >> (direction == 0 ? 4 : 5)) & bitboard_cells;
+	}
+	return (set << (direction == 0 ? 5 : 4)) & bitboard_cells;
+}
+
+// Converts the board of the wire position to a bitboard
+inline tucants_bitboard to_bitboard(const Position& pos){
+	tucants_bitboard bb;
+
+	bb.ants[WHITE] = 0;
+	bb.ants[BLACK] = 0;
+	bb.food = 0;
+
+	for (int i = 0; i < BOARD_ROWS; ++i){
+		for (int j = (i + 1)%2; j < BOARD_COLUMNS; j += 2){
+			std::uint64_t cell = 1ULL << bitboard_index(i, j);
+
+			switch(pos.board[i][j]){
+			case WHITE:
+				bb.ants[WHITE] |= cell;
+				break;
+			case BLACK:
+				bb.ants[BLACK] |= cell;
+				break;
+			case RTILE:
+				bb.food |= cell;
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return bb;
+}
+
+// Writes the bitboard back to the board of the wire position. The score and the turn of the position are left as
+// they are.
+inline void to_position(const tucants_bitboard& bb, Position& pos){
+	for (int i = 0; i < BOARD_ROWS; ++i){
+		for (int j = 0; j < BOARD_COLUMNS; ++j){
+			if ((i + j)%2 == 0){
+				pos.board[i][j] = EMPTY;
+				continue;
+			}
+
+			std::uint64_t cell = 1ULL << bitboard_index(i, j);
+
+			if (bb.ants[WHITE] & cell){
+				pos.board[i][j] = WHITE;
+			}
+			else if (bb.ants[BLACK] & cell){
+				pos.board[i][j] = BLACK;
+			}
+			else if (bb.food & cell){
+				pos.board[i][j] = RTILE;
+			}
+			else{
+				pos.board[i][j] = EMPTY;
+			}
+		}
+	}
+}
+
+// Returns the set of the ants of the given color that can capture an opponent ant
+inline std::uint64_t bitboard_capturers(const tucants_bitboard& bb, char color){
+	std::uint64_t empty = bb.empty();
+	std::uint64_t opponent = bb.ants[1 - color];
+	std::uint64_t capturers = 0;
+
+	for (int direction = 0; direction < 2; ++direction){
+		capturers |= bitboard_backward(opponent & bitboard_backward(empty, color, direction), color, direction);
+	}
+
+	return capturers & bb.ants[static_cast<int>(color)];
+}
+
+// Sets the i-th tile of the move to the cell with the given bit
+inline void bitboard_set_tile(Move& move, int i, int bit){
+	move.tile[0][i] = bitboard_row(bit);
+	move.tile[1][i] = bitboard_column(bit);
+}
+
+// Extends the capture chain of move whose last tile is the length-th one, at the cell with the given bit.
+// Every maximal chain (one that can't capture any more) is written to out and counted in count.
+template<class OutputIterator>
+void bitboard_capture_chains(const tucants_bitboard& bb, char color, std::uint64_t empty, Move& move, int length, int bit, OutputIterator& out, int& count){
+	bool extended = false;
+
+	// a move has at most MAXIMUM_MOVE_SIZE tiles (which is also as far as an ant can jump in the board)
+	if (length + 1 < MAXIMUM_MOVE_SIZE){
+		for (int direction = 0; direction < 2; ++direction){
+			std::uint64_t over = bitboard_forward(1ULL << bit, color, direction) & bb.ants[1 - color];
+			std::uint64_t land = bitboard_forward(over, color, direction) & empty;
+
+			if (land){
+				int next = bitboard_first(land);
+
+				bitboard_set_tile(move, length + 1, next);
+				bitboard_capture_chains(bb, color, empty, move, length + 1, next, out, count);
+				extended = true;
+			}
+		}
+	}
+
+	if (!extended && length > 0){
+		if (length + 1 < MAXIMUM_MOVE_SIZE){
+			move.tile[0][length + 1] = -1;
+		}
+		*out++ = move;
+		++count;
+	}
+}
+
+// Writes to out every capture move of the player with the given color. Returns the number of moves written.
+template<class OutputIterator>
+int bitboard_capture_moves(const tucants_bitboard& bb, char color, OutputIterator out){
+	std::uint64_t empty = bb.empty();
+	std::uint64_t capturers = bitboard_capturers(bb, color);
+	int count = 0;
+
+	while (capturers){
+		int bit = bitboard_first(capturers);
+		capturers &= capturers - 1;
+
+		Move move;
+		move.color = color;
+		bitboard_set_tile(move, 0, bit);
+
+		bitboard_capture_chains(bb, color, empty, move, 0, bit, out, count);
+	}
+
+	return count;
+}
+
+// Writes to out every move of the player with the given color that doesn't capture. Returns the number of moves
+// written.
+template<class OutputIterator>
+int bitboard_simple_moves(const tucants_bitboard& bb, char color, OutputIterator out){
+	std::uint64_t empty = bb.empty();
+	int count = 0;
+
+	for (int direction = 0; direction < 2; ++direction){
+		std::uint64_t targets = bitboard_forward(bb.ants[static_cast<int>(color)], color, direction) & empty;
+
+		while (targets){
+			std::uint64_t target = targets & (0 - targets);
+			targets ^= target;
+
+			Move move;
+			move.color = color;
+			bitboard_set_tile(move, 0, bitboard_first(bitboard_backward(target, color, direction)));
+			bitboard_set_tile(move, 1, bitboard_first(target));
+			move.tile[0][2] = -1;
+
+			*out++ = move;
+			++count;
+		}
+	}
+
+	return count;
+}
+
+// Writes to out the legal moves of the player with the given color: the capture moves if there is any (capturing
+// is mandatory) and the simple moves otherwise. Returns the number of moves written.
+template<class OutputIterator>
+int bitboard_moves(const tucants_bitboard& bb, char color, OutputIterator out){
+	if (bitboard_capturers(bb, color)){
+		return bitboard_capture_moves(bb, color, out);
+	}
+	return bitboard_simple_moves(bb, color, out);
+}
+
+// Returns the set of the ants of the given color that can capture an opponent ant in the given direction
+inline std::uint64_t bitboard_capturers(const tucants_bitboard& bb, char color, int direction){
+	std::uint64_t landing = bitboard_backward(bb.empty(), color, direction);
+
+	return bitboard_backward(bb.ants[1 - color] & landing, color, direction) & bb.ants[static_cast<int>(color)];
+}
+
+// Counts the capture chains that extend the chain whose last tile is the length-th one, at the cell with the given
+// bit, the way bitboard_capture_chains() writes them: every maximal chain adds one to chains and the ants it
+// captures to captured.
+inline void bitboard_count_capture_chains(const tucants_bitboard& bb, char color, std::uint64_t empty, int length, int bit, int& chains, int& captured){
+	bool extended = false;
+
+	if (length + 1 < MAXIMUM_MOVE_SIZE){
+		for (int direction = 0; direction < 2; ++direction){
+			std::uint64_t over = bitboard_forward(1ULL << bit, color, direction) & bb.ants[1 - color];
+			std::uint64_t land = bitboard_forward(over, color, direction) & empty;
+
+			if (land){
+				bitboard_count_capture_chains(bb, color, empty, length + 1, bitboard_first(land), chains, captured);
+				extended = true;
+			}
+		}
+	}
+
+	if (!extended && length > 0){
+		++chains;
+		captured += length;
+	}
+}
+
+// Returns the mobility of the player with the given color: the moves each of its ants could make on its own,
+// plus the ants they capture. An ant moves to an empty cell unless it can capture in the other direction, and
+// captures with every chain it can make (whether or not another ant has to capture instead, unlike
+// bitboard_moves()). The simple moves take a few shifts and popcounts, the chains are only walked for the ants
+// that can capture.
+inline int bitboard_mobility(const tucants_bitboard& bb, char color){
+	std::uint64_t empty = bb.empty();
+	std::uint64_t ants = bb.ants[static_cast<int>(color)];
+	std::uint64_t capturers[2] = {bitboard_capturers(bb, color, 0), bitboard_capturers(bb, color, 1)};
+	int chains = 0;
+	int captured = 0;
+
+	for (std::uint64_t rest = capturers[0] | capturers[1]; rest != 0; rest &= rest - 1){
+		bitboard_count_capture_chains(bb, color, empty, 0, bitboard_first(rest), chains, captured);
+	}
+
+	int simple = __builtin_popcountll(bitboard_forward(ants & ~capturers[1], color, 0) & empty) + __builtin_popcountll(bitboard_forward(ants & ~capturers[0], color, 1) & empty);
+
+	return simple + chains + captured;
+}
+
+// Returns whether the player with the given color has any move (other than the null move)
+inline bool bitboard_has_moves(const tucants_bitboard& bb, char color){
+	std::uint64_t ants = bb.ants[static_cast<int>(color)];
+
+	return bitboard_capturers(bb, color) != 0 || ((bitboard_forward(ants, color, 0) | bitboard_forward(ants, color, 1)) & bb.empty()) != 0;
+}
+
+// Returns the bit of the i-th tile of the move, or -1 if the tile is not a cell of the board
+inline int bitboard_tile(const Move& move, int i){
+	int row = move.tile[0][i];
+	int column = move.tile[1][i];
+
+	if (row < 0 || row >= BOARD_ROWS || column < 0 || column >= BOARD_COLUMNS || (row + column)%2 == 0){
+		return -1;
+	}
+	return bitboard_index(row, column);
+}
+
+// Returns whether the move is one of the moves bitboard_moves() writes for the player with the given color,
+// without generating them: a simple move when there are no captures or a maximal capture chain otherwise
+inline bool bitboard_is_move(const tucants_bitboard& bb, char color, const Move& move){
+	if (move.color != color || move.tile[0][0] == -1){
+		return false;
+	}
+
+	std::uint64_t empty = bb.empty();
+	std::uint64_t opponent = bb.ants[1 - color];
+	int bit = bitboard_tile(move, 0);
+
+	if (bit < 0 || !(bb.ants[static_cast<int>(color)] & (1ULL << bit))){
+		return false;
+	}
+
+	int length = 0;
+
+	while (length + 1 < MAXIMUM_MOVE_SIZE && move.tile[0][length + 1] != -1){
+		++length;
+	}
+
+	if (length == 0){
+		return false;
+	}
+
+	if (bitboard_capturers(bb, color) == 0){
+		// a simple move: one step forward to an empty cell
+		int to = bitboard_tile(move, 1);
+
+		return length == 1 && to >= 0 && (empty & (1ULL << to)) && (bitboard_forward(1ULL << bit, color, 0) | bitboard_forward(1ULL << bit, color, 1)) & (1ULL << to);
+	}
+
+	// a capture chain: every step jumps over an opponent ant to an empty cell...
+	for (int i = 1; i <= length; ++i){
+		int next = bitboard_tile(move, i);
+		bool jump = false;
+
+		if (next < 0){
+			return false;
+		}
+
+		for (int direction = 0; direction < 2; ++direction){
+			std::uint64_t over = bitboard_forward(1ULL << bit, color, direction) & opponent;
+
+			if (bitboard_forward(over, color, direction) & empty & (1ULL << next)){
+				jump = true;
+			}
+		}
+
+		if (!jump){
+			return false;
+		}
+		bit = next;
+	}
+
+	// ...and it can't be extended (see bitboard_capture_chains())
+	if (length + 1 < MAXIMUM_MOVE_SIZE){
+		for (int direction = 0; direction < 2; ++direction){
+			std::uint64_t over = bitboard_forward(1ULL << bit, color, direction) & opponent;
+
+			if (bitboard_forward(over, color, direction) & empty){
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Plays the move at the bitboard the way doMove() does at a position: the ant leaves its cell, the ants jumped
+// over are captured, the food on the cells the ant lands on is consumed and the ant is placed at the last cell
+// unless that is the last row for it (where it scores and leaves the board).
+inline void bitboard_do_move(tucants_bitboard& bb, const Move& move){
+	if (move.tile[0][0] == -1){
+		return;
+	}
+
+	int color = move.color;
+	int from = bitboard_index(move.tile[0][0], move.tile[1][0]);
+	int to = from;
+
+	bb.ants[color] &= ~(1ULL << from);
+
+	for (int i = 1; i < MAXIMUM_MOVE_SIZE && move.tile[0][i] != -1; ++i){
+		to = bitboard_index(move.tile[0][i], move.tile[1][i]);
+
+		if (abs(move.tile[0][i] - move.tile[0][i - 1]) == 2){
+			bb.ants[1 - color] &= ~(1ULL << bitboard_index((move.tile[0][i] + move.tile[0][i - 1])/2, (move.tile[1][i] + move.tile[1][i - 1])/2));
+		}
+
+		bb.food &= ~(1ULL << to);
+	}
+
+	int last_row = (color == WHITE) ? BOARD_ROWS - 1 : 0;
+
+	if (bitboard_row(to) != last_row){
+		bb.ants[color] |= 1ULL << to;
+	}
+}
+
+#endif /* TUCANTS_BITBOARD_HPP_ */
@@ -21,38 +21,17 @@
 #include<utility>
 #include<tuple>
 #include<list>
+#include<vector>
 #include<limits>
+#include<cstdint>
+#include<cstdlib>
+#include<iostream>
 #include"minimax.hpp"
+#include"fixed_vector.hpp"
 #include"tucants_all.hpp"
+#include"tucants_bitboard.hpp"
 #include"time_limit_cutoff_test.hpp"
 
-// The state of the game.
-struct tucants_game{
-	Position pos; // the state of the player
-	char player; // who color am i?
-
-	bool is_chance_node;
-	int food_obtained;
-	Move move; // this one is only used for chance nodes. Which was the move that resulted in this chance node;
-
-	int player_num_ants_captured; // how many ants have i captured
-	int opponent_num_ants_captured; // how many ants the opponent has captured
-
-	search::StateNodeType node_type() const{
-		if (is_chance_node){
-			return search::StateNodeType::CHANCE_NODE;
-		}
-		return pos.turn == player ? search::StateNodeType::MAX_NODE : search::StateNodeType::MIN_NODE;
-	}
-
-	void init(){
-		is_chance_node = false;
-		food_obtained = 0;
-		player_num_ants_captured = 0;
-		opponent_num_ants_captured = 0;
-	}
-};
-
 static const int board_utilities[2][12][8] = {
 		{ // from the white player point of view
 				{0,2,0,2,0,2,0,2},
@@ -84,6 +63,382 @@ static const int board_utilities[2][12][8] = {
 		}
 };
 
+// The terms of the evaluation of each player that depend only on where its ants stand (see player_utility()).
+// They are kept with the state and updated with each move that changes the ants of a player, so that the
+// evaluation doesn't have to scan the board for them.
+struct tucants_evaluation_terms{
+	int positional[2]; // the sum of the board utilities of the ants of each color
+	int ants[2]; // the number of ants of each color
+	int protection[2]; // the pairs of ants of each color one of which stands a step forward of the other
+
+	bool operator==(const tucants_evaluation_terms& other) const{
+		for (int color = 0; color < 2; ++color){
+			if (positional[color] != other.positional[color] || ants[color] != other.ants[color] || protection[color] != other.protection[color]){
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+// The board utilities as bit planes: the utility of an ant of a color at a cell is the sum of 2^k over the planes
+// k whose mask (of that color) holds the cell. The utilities of a whole set of ants then take a popcount per plane
+// instead of a look up per ant.
+struct tucants_utility_planes{
+	static const int num_planes = 3; // enough for the utilities up to 7
+
+	std::uint64_t masks[2][num_planes];
+
+	tucants_utility_planes(){
+		for (int color = 0; color < 2; ++color){
+			for (int k = 0; k < num_planes; ++k){
+				masks[color][k] = 0;
+			}
+
+			for (int i = 0; i < BOARD_ROWS; ++i){
+				for (int j = (i + 1)%2; j < BOARD_COLUMNS; j += 2){
+					int utility = board_utilities[color][i][j];
+
+					assert(utility >= 0 && utility < (1 << num_planes) && "tucants_utility_planes: board utility out of range");
+
+					for (int k = 0; k < num_planes; ++k){
+						if (utility & (1 << k)){
+							masks[color][k] |= 1ULL << bitboard_index(i, j);
+						}
+					}
+				}
+			}
+		}
+	}
+};
+
+static const tucants_utility_planes utility_planes;
+
+// Returns the sum of the board utilities of the set of ants of the given color
+inline int positional_utility(std::uint64_t ants, char color){
+	int utility = 0;
+
+	for (int k = 0; k < tucants_utility_planes::num_planes; ++k){
+		utility += __builtin_popcountll(ants & utility_planes.masks[static_cast<int>(color)][k]) << k;
+	}
+
+	return utility;
+}
+
+// Computes the evaluation terms of the ants of the given color, which takes a few shifts and popcounts
+inline void color_evaluation_terms(tucants_evaluation_terms& terms, std::uint64_t ants, char color){
+	terms.positional[static_cast<int>(color)] = positional_utility(ants, color);
+	terms.ants[static_cast<int>(color)] = __builtin_popcountll(ants);
+	terms.protection[static_cast<int>(color)] = __builtin_popcountll(bitboard_forward(ants, color, 0) & ants) + __builtin_popcountll(bitboard_forward(ants, color, 1) & ants);
+}
+
+// Computes the evaluation terms of the bitboard from scratch
+inline tucants_evaluation_terms evaluation_terms(const tucants_bitboard& bb){
+	tucants_evaluation_terms terms;
+
+	color_evaluation_terms(terms, bb.ants[WHITE], WHITE);
+	color_evaluation_terms(terms, bb.ants[BLACK], BLACK);
+
+	return terms;
+}
+
+// Updates the evaluation terms of the bitboard before to those of the bitboard after: the terms of a color are
+// computed again only if its ants have changed
+inline void update_evaluation_terms(tucants_evaluation_terms& terms, const tucants_bitboard& before, const tucants_bitboard& after){
+	for (int color = 0; color < 2; ++color){
+		if (before.ants[color] != after.ants[color]){
+			color_evaluation_terms(terms, after.ants[color], color);
+		}
+	}
+}
+
+// The state of the game.
+struct tucants_game{
+	Position pos; // the state of the player
+	char player; // who color am i?
+
+	bool is_chance_node;
+	int food_obtained;
+	Move move; // this one is only used for chance nodes. Which was the move that resulted in this chance node;
+	int food_cells; // this one is only used for chance nodes. How many cells with food the move landed on
+
+	int player_num_ants_captured; // how many ants have i captured
+	int opponent_num_ants_captured; // how many ants the opponent has captured
+
+	std::uint64_t key; // the Zobrist hash key of the state. It is maintained incrementally as moves are made
+				// (see tucants_do_move()) and it must be recomputed with tucants_rehash() when pos is changed directly
+	tucants_bitboard bb; // the board of pos as bitboards. Maintained along with the key.
+	tucants_evaluation_terms terms; // the evaluation terms of bb. Maintained along with the key.
+
+	search::StateNodeType node_type() const{
+		if (is_chance_node){
+			return search::StateNodeType::CHANCE_NODE;
+		}
+		return pos.turn == player ? search::StateNodeType::MAX_NODE : search::StateNodeType::MIN_NODE;
+	}
+
+	void init(){
+		is_chance_node = false;
+		food_obtained = 0;
+		food_cells = 0;
+		player_num_ants_captured = 0;
+		opponent_num_ants_captured = 0;
+	}
+};
+
+// Two moves are equal if they are made by the same color and visit the same tiles
+inline bool operator==(const Move& a, const Move& b){
+	if (a.color != b.color){
+		return false;
+	}
+
+	for (int i = 0; i < MAXIMUM_MOVE_SIZE; ++i){
+		if (a.tile[0][i] != b.tile[0][i]){
+			return false;
+		}
+		if (a.tile[0][i] == -1){
+			// the rest of the tiles are unused
+			return true;
+		}
+		if (a.tile[1][i] != b.tile[1][i]){
+			return false;
+		}
+	}
+
+	return true;
+}
+
+inline bool operator!=(const Move& a, const Move& b){
+	return !(a == b);
+}
+
+// The maximum number of moves a player can have at a position (the maximum branching factor of the game).
+// 12 ants have at most 24 moves that don't capture; the capture chains are bounded by how the jumps of an ant
+// can branch within the 4 cells of a row and by the 12 ants of the opponent. The most moves found by a search
+// over random positions is 26, so this leaves ample room.
+static const std::size_t tucants_max_moves = 128;
+
+// A list of moves that doesn't allocate. The move generators write into it directly.
+typedef search::fixed_vector<Move, tucants_max_moves> tucants_move_list;
+
+// The random keys used for Zobrist hashing of the game states. The hash key of a state is the XOR of the keys of
+// the contents of each cell (an empty cell contributes nothing), of the player who has turn, of the chance node
+// flag, of the food obtained and of the score of each player.
+struct tucants_zobrist_keys{
+	// the score of a player can't realistically exceed this (12 ants reaching the end plus the food)
+	static const int max_score = 64;
+
+	std::uint64_t cells[BOARD_ROWS][BOARD_COLUMNS][4]; // indexed by WHITE, BLACK, EMPTY (unused) and RTILE
+	std::uint64_t turn[2];
+	std::uint64_t chance_node[3]; // indexed by the number of food cells of the move of the chance node
+	std::uint64_t food_obtained[3];
+	std::uint64_t score[2][max_score];
+
+	tucants_zobrist_keys(){
+		// the keys are produced from a fixed seed so that they are the same in every run
+		std::uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+		for (int i = 0; i < BOARD_ROWS; ++i){
+			for (int j = 0; j < BOARD_COLUMNS; ++j){
+				for (int k = 0; k < 4; ++k){
+					cells[i][j][k] = (k == EMPTY) ? 0 : next(seed);
+				}
+			}
+		}
+		turn[WHITE] = next(seed);
+		turn[BLACK] = next(seed);
+		for (int i = 0; i < 3; ++i){
+			chance_node[i] = next(seed);
+		}
+		for (int i = 0; i < 3; ++i){
+			food_obtained[i] = next(seed);
+		}
+		for (int i = 0; i < 2; ++i){
+			for (int j = 0; j < max_score; ++j){
+				score[i][j] = next(seed);
+			}
+		}
+	}
+private:
+	// splitmix64 generator
+	static std::uint64_t next(std::uint64_t& state){
+		std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+};
+
+static const tucants_zobrist_keys zobrist_keys;
+
+// Computes from scratch the Zobrist hash key of the given game state
+inline std::uint64_t tucants_hash(const tucants_game& game){
+	std::uint64_t key = 0;
+
+	for (int i = 0; i < BOARD_ROWS; ++i){
+		for (int j = 0; j < BOARD_COLUMNS; ++j){
+			char cell = game.pos.board[i][j];
+
+			if (cell == WHITE || cell == BLACK || cell == RTILE){
+				key ^= zobrist_keys.cells[i][j][static_cast<int>(cell)];
+			}
+		}
+	}
+
+	key ^= zobrist_keys.turn[static_cast<int>(game.pos.turn)];
+
+	if (game.is_chance_node){
+		key ^= zobrist_keys.chance_node[game.food_cells];
+	}
+
+	key ^= zobrist_keys.food_obtained[game.food_obtained];
+	key ^= zobrist_keys.score[WHITE][game.pos.score[WHITE] & (tucants_zobrist_keys::max_score - 1)];
+	key ^= zobrist_keys.score[BLACK][game.pos.score[BLACK] & (tucants_zobrist_keys::max_score - 1)];
+
+	return key;
+}
+
+// Recomputes from scratch the hash key and the bitboards stored in the game. It must be called whenever the
+// position of the game is set directly (e.g. when received from the server).
+inline void tucants_rehash(tucants_game& game){
+	game.key = tucants_hash(game);
+	game.bb = to_bitboard(game.pos);
+	game.terms = evaluation_terms(game.bb);
+}
+
+// In debug hash mode every incrementally computed key (and the bitboards and the evaluation terms) is checked
+// against a full recomputation
+inline void tucants_check_hash(const tucants_game& game){
+#ifdef _DEBUG_HASH_
+	if (game.key != tucants_hash(game)){
+		std::cerr << "tucants_check_hash(): incremental key " << game.key << " differs from full key " << tucants_hash(game) << std::endl;
+		std::abort();
+	}
+	if (!(game.bb == to_bitboard(game.pos))){
+		std::cerr << "tucants_check_hash(): bitboards differ from the position" << std::endl;
+		std::abort();
+	}
+	if (!(game.terms == evaluation_terms(game.bb))){
+		std::cerr << "tucants_check_hash(): incremental evaluation terms differ from the full ones" << std::endl;
+		std::abort();
+	}
+#else
+	(void)game;
+#endif
+}
+
+// Sets whether the game is a chance node (and for how many food cells), updating its hash key
+inline void tucants_set_chance_node(tucants_game& game, bool is_chance_node, int food_cells = 0){
+	if (game.is_chance_node){
+		game.key ^= zobrist_keys.chance_node[game.food_cells];
+	}
+	if (is_chance_node){
+		game.key ^= zobrist_keys.chance_node[food_cells];
+	}
+	game.is_chance_node = is_chance_node;
+	game.food_cells = is_chance_node ? food_cells : 0;
+}
+
+// Sets the food obtained at the game, updating its hash key
+inline void tucants_set_food_obtained(tucants_game& game, int food_obtained){
+	game.key ^= zobrist_keys.food_obtained[game.food_obtained] ^ zobrist_keys.food_obtained[food_obtained];
+	game.food_obtained = food_obtained;
+}
+
+// Adds to the score of the player with the given color, updating the hash key of the game
+inline void tucants_add_score(tucants_game& game, char color, int points){
+	char& score = game.pos.score[static_cast<int>(color)];
+
+	game.key ^= zobrist_keys.score[static_cast<int>(color)][score & (tucants_zobrist_keys::max_score - 1)];
+	score += points;
+	game.key ^= zobrist_keys.score[static_cast<int>(color)][score & (tucants_zobrist_keys::max_score - 1)];
+}
+
+// Returns the XOR of the keys of the contents of the cells touched by the move at the given position and
+// of the keys of the score and of the turn. These are the only parts of the position that doMove() changes, so
+// XORing this before and after the move updates a hash key. The cells touched are the tiles of the move
+// (the intermediate ones included) and the cells of the ants captured in between jumps.
+inline std::uint64_t touched_cells_hash(const Position& pos, const Move& move){
+	std::uint64_t key = zobrist_keys.turn[static_cast<int>(pos.turn)];
+
+	key ^= zobrist_keys.score[WHITE][pos.score[WHITE] & (tucants_zobrist_keys::max_score - 1)];
+	key ^= zobrist_keys.score[BLACK][pos.score[BLACK] & (tucants_zobrist_keys::max_score - 1)];
+
+	for (int i = 0; i < MAXIMUM_MOVE_SIZE; ++i){
+		if (move.tile[0][i] == -1){
+			break;
+		}
+
+		int x = move.tile[0][i];
+		int y = move.tile[1][i];
+		char cell = pos.board[x][y];
+
+		if (cell == WHITE || cell == BLACK || cell == RTILE){
+			key ^= zobrist_keys.cells[x][y][static_cast<int>(cell)];
+		}
+
+		// the captured ant lies in the middle of a jump
+		if (i > 0 && abs(move.tile[0][i] - move.tile[0][i - 1]) == 2){
+			int cx = (move.tile[0][i] + move.tile[0][i - 1])/2;
+			int cy = (move.tile[1][i] + move.tile[1][i - 1])/2;
+			char captured = pos.board[cx][cy];
+
+			if (captured == WHITE || captured == BLACK || captured == RTILE){
+				key ^= zobrist_keys.cells[cx][cy][static_cast<int>(captured)];
+			}
+		}
+	}
+
+	return key;
+}
+
+// Plays the move at the position the way doMove() does, except for the food: the food of the cells the ant lands
+// on is consumed but never scored. doMove() draws with rand() whether each food is obtained, the search leaves
+// that to the chance node of the move instead (see tucants_apply_outcome()), so that its results are reproducible
+// and its threads don't contend for the lock of rand().
+inline void tucants_move_position(Position& pos, const Move& move){
+	if (move.tile[0][0] != -1){
+		for (int i = 1; i < MAXIMUM_MOVE_SIZE && move.tile[0][i] != -1; ++i){
+			int x = move.tile[0][i];
+			int y = move.tile[1][i];
+
+			pos.board[move.tile[0][i - 1]][move.tile[1][i - 1]] = EMPTY;
+
+			// the ant jumped over is captured
+			if (abs(x - move.tile[0][i - 1]) == 2){
+				pos.board[(x + move.tile[0][i - 1])/2][(y + move.tile[1][i - 1])/2] = EMPTY;
+			}
+
+			if (x == 0){
+				++pos.score[BLACK];
+			}
+			else if (x == BOARD_ROWS - 1){
+				++pos.score[WHITE];
+			}
+			else{
+				pos.board[x][y] = move.color;
+			}
+		}
+	}
+
+	pos.turn = 1 - pos.turn;
+}
+
+// Plays the move at the game (with tucants_move_position()) and updates the hash key, the bitboards and the
+// evaluation terms of the game incrementally, in time proportional to the length of the move.
+inline void tucants_do_move(tucants_game& game, const Move& move){
+	std::uint64_t key = game.key ^ touched_cells_hash(game.pos, move);
+	tucants_bitboard before = game.bb;
+
+	tucants_move_position(game.pos, move);
+	bitboard_do_move(game.bb, move);
+	update_evaluation_terms(game.terms, before, game.bb);
+
+	game.key = key ^ touched_cells_hash(game.pos, move);
+
+	tucants_check_hash(game);
+}
+
 // Returns true if the (i,j) position is inside the regions of the board and false otherwise.
 inline bool is_inside_board(int i, int j){
 	return (0 <= i) && (i < BOARD_ROWS) && (0 <= j) && (j < BOARD_COLUMNS);
@@ -296,26 +651,31 @@ inline std::pair<int,int> make_move_in_same_direction(int i, int j, int x, int y
 	}
 }
 
-// continue a captivity move. Source is (i,j) and at (x,y) we found an opponent ant!
-// we return a list of moves cause it may happen that after the first capture, we can do two more and thus
-// we get one more move.
-inline std::list<Move> which_moves_captivity_case(const Position& pos, int i, int j, int x, int y, char color){
+// continue a captivity move. The move made so far has its last tile, the length-th one, at (i,j) and at (x,y)
+// we found an opponent ant! Every move it may lead to is written to out, because it may happen that after
+// the first capture, we can do two more and thus we get one more move. Returns the number of moves written.
+template<class OutputIterator>
+int which_moves_captivity_case(const Position& pos, Move& move, int length, int x, int y, char color, OutputIterator& out){
+	int i = move.tile[0][length];
+	int j = move.tile[1][length];
+
 	std::pair<int,int> next = make_move_in_same_direction(i, j, x, y, color);
 
 	int next_x = next.first;
 	int next_y = next.second;
 
-	std::list<Move> moves;
-
 	if (!is_inside_board(next_x, next_y)){
-		return moves;
+		return 0;
 	}
 
 	// if the cell at (next_x,next_y) isn't empty then we do nothing
 	if (has_ant(pos, next_x,next_y)){
-		return moves;
+		return 0;
 	}
 
+	move.tile[0][length + 1] = next_x;
+	move.tile[1][length + 1] = next_y;
+
 	// now we can move there but we may be apply to do more captivity moves and we must check them also
 	std::pair<std::pair<int,int>,std::pair<int,int> > possible = move_once(next_x, next_y, color);
 
@@ -325,351 +685,316 @@ inline std::list<Move> which_moves_captivity_case(const Position& pos, int i, in
 	int x2 = possible.second.first;
 	int y2 = possible.second.second;
 
-	bool made_more_captures = false;
+	int count = 0;
+
+	// a move has at most MAXIMUM_MOVE_SIZE tiles
+	if (length + 2 < MAXIMUM_MOVE_SIZE){
+		if (is_inside_board(x1,y1) && has_ant(pos, x1, y1) && (pos.board[x1][y1] != color)){
+			count += which_moves_captivity_case(pos, move, length + 1, x1, y1, color, out);
+		}
+
+		if (is_inside_board(x2,y2) && has_ant(pos, x2, y2) && (pos.board[x2][y2] != color)){
+			count += which_moves_captivity_case(pos, move, length + 1, x2, y2, color, out);
+		}
+	}
 
-	if (is_inside_board(x1,y1) && has_ant(pos, x1, y1) && (pos.board[x1][y1] != color)){
-		std::list<Move> new_moves = which_moves_captivity_case(pos, next_x, next_y, x1, y1, color);
+	// if no more captures could be made the move ends here
+	if (count == 0){
+		if (length + 2 < MAXIMUM_MOVE_SIZE){
+			move.tile[0][length + 2] = -1;
+		}
 
-		for (auto it = new_moves.begin(); it != new_moves.end(); ++it){
-			Move m;
+		*out++ = move;
+		count = 1;
+	}
 
-			m.color = color;
+	return count;
+}
 
-			m.tile[0][0] = i;
-			m.tile[1][0] = j;
-			m.tile[0][1] = next_x;
-			m.tile[1][1] = next_y;
+// Returns whether the ant at (i,j) of the given color can capture the ant at (x,y), which is one step away from
+// it, that is whether (x,y) has an opponent ant and the cell behind it is inside the board and empty.
+inline bool can_capture(const Position& pos, int i, int j, int x, int y, char color){
+	if (!is_inside_board(x, y) || !has_ant(pos, x, y) || of_same_color(pos, i, j, x, y)){
+		return false;
+	}
 
-			for (int i = 2, j = 1; i < 6; ++i, ++j){
-				m.tile[0][i] = it->tile[0][j];
-				m.tile[1][i] = it->tile[1][j];
+	std::pair<int,int> next = make_move_in_same_direction(i, j, x, y, color);
 
-				if (m.tile[0][i] == -1){
-					break;
-				}
-			}
+	return is_inside_board(next.first, next.second) && !has_ant(pos, next.first, next.second);
+}
 
-			moves.push_back(m);
+// Writes to out the possible moves that the ant at the given (i,j) position can make. A move to an empty cell
+// is not written if the ant can capture in the other direction. Returns the number of moves written (zero if no
+// move can be made).
+template<class OutputIterator>
+int which_moves(const Position& pos, int i, int j, OutputIterator out){
+	assert(pos.board[i][j] <= 1 && "which_moves() : no ant at (i,j) position");
 
-			made_more_captures = true;
-		}
-	}
+	char color = pos.board[i][j];
 
-	if (is_inside_board(x2,y2) && has_ant(pos, x2, y2) && (pos.board[x2][y2] != color)){
-		std::list<Move> new_moves = which_moves_captivity_case(pos, next_x, next_y, x2, y2, color);
+	// take the initial destinations
+	std::pair<std::pair<int,int>, std::pair<int,int> > dest = move_once(i,j,color);
 
-		for (auto it = new_moves.begin(); it != new_moves.end(); ++it){
-			Move m;
+	int count = 0;
 
-			m.color = color;
+	Move move;
 
-			m.tile[0][0] = i;
-			m.tile[1][0] = j;
-			m.tile[0][1] = next_x;
-			m.tile[1][1] = next_y;
+	move.color = color;
+	move.tile[0][0] = i;
+	move.tile[1][0] = j;
 
-			for (int i = 2, j = 1; i < 6; ++i, ++j){
-				m.tile[0][i] = it->tile[0][j];
-				m.tile[1][i] = it->tile[1][j];
+	// (x1,y1) is the first destination and (x2,y2) the second destination
+	int x[2] = {dest.first.first, dest.second.first};
+	int y[2] = {dest.first.second, dest.second.second};
 
-				if (m.tile[0][i] == -1){
-					break;
-				}
-			}
+	for (int d = 0; d < 2; ++d){
+		// (x[d],y[d]) can be either empty or have an opponent ant
+		if (!is_inside_board(x[d], y[d]) || of_same_color(pos, i, j, x[d], y[d])){
+			continue;
+		}
 
-			moves.push_back(m);
+		if (!has_ant(pos, x[d], y[d])){
+			// if it is empty then we store this move only if the move to the other destination doesn't have
+			// captivity precedence
+			if (!can_capture(pos, i, j, x[1 - d], y[1 - d], color)){
+				move.tile[0][1] = x[d];
+				move.tile[1][1] = y[d];
+				move.tile[0][2] = -1;
 
-			made_more_captures = true;
+				*out++ = move;
+				++count;
+			}
+		}
+		else{
+			// else there is an opponent ant there
+			count += which_moves_captivity_case(pos, move, 0, x[d], y[d], color, out);
 		}
 	}
 
-	if (!made_more_captures){
-		assert(moves.empty() && "which_moves_captivity_case() : moves ought to be empty");
+	return count;
+}
 
-		Move move;
+// The record needed to undo a move (or the outcome of a chance node) made with tucants_apply() or
+// tucants_apply_outcome(). The board is restored from the move itself: the moving ant goes back to its cell,
+// the captured ants of the opponent are placed back and the cells the ant landed on get back their food from
+// the saved bitboards.
+struct tucants_undo{
+	Move move; // the move made (the null move for an outcome)
+	tucants_bitboard bb; // the bitboards before the move, which also tell which cells had food
+	tucants_evaluation_terms terms;
+	std::uint64_t key;
+	char score[2];
+	char turn;
+	bool is_chance_node;
+	int food_obtained;
+	int food_cells;
+};
 
-		move.color = color;
+// Returns how many cells with food the move lands on (at most 2, see the successor function)
+inline int food_cells_landed(const tucants_game& game, const Move& move){
+	int num_food_cells = 0;
 
-		move.tile[0][0] = i;
-		move.tile[1][0] = j;
-		move.tile[0][1] = next_x;
-		move.tile[1][1] = next_y;
-		move.tile[0][2] = -1;
+	for (int i = 1; i < MAXIMUM_MOVE_SIZE && move.tile[0][0] != -1; ++i){
+		if (move.tile[0][i] == -1){
+			break;
+		}
 
-		moves.push_back(move);
+		if (game.pos.board[move.tile[0][i]][move.tile[1][i]] == RTILE){
+			++num_food_cells;
+		}
 	}
 
-	return moves;
+	return std::min(num_food_cells, 2);
 }
 
-// Returns the possible moves that an ant at the given (i,j) position can make.
-// If no move can be made then an empty list is returned instead.
-inline std::list<Move> which_moves(const Position& pos, int i, int j){
-	assert(pos.board[i][j] <= 1 && "which_moves() : no ant at (i,j) position");
+// Saves at undo what is needed to undo a change of the game
+inline void tucants_save(const tucants_game& game, const Move& move, tucants_undo& undo){
+	undo.move = move;
+	undo.bb = game.bb;
+	undo.terms = game.terms;
+	undo.key = game.key;
+	undo.score[WHITE] = game.pos.score[WHITE];
+	undo.score[BLACK] = game.pos.score[BLACK];
+	undo.turn = game.pos.turn;
+	undo.is_chance_node = game.is_chance_node;
+	undo.food_obtained = game.food_obtained;
+	undo.food_cells = game.food_cells;
+}
 
-	char color = pos.board[i][j];
+// Plays the move at the game, as a child of the game in the search tree: if the move lands on food the game
+// becomes a chance node. What is needed to undo the move is saved at undo.
+inline void tucants_apply(tucants_game& game, const Move& move, tucants_undo& undo){
+	tucants_save(game, move, undo);
 
-	// take the initial destinations
-	std::pair<std::pair<int,int>, std::pair<int,int> > dest = move_once(i,j,color);
+	// here we look out for chance nodes. More specifically if we land to a cell with food we baptize
+	// that node a chance node. The food must be looked for before the move consumes it.
+	int num_food_cells = food_cells_landed(game, move);
 
-	std::list<Move> moves;
+	tucants_set_chance_node(game, false);
+	tucants_set_food_obtained(game, 0);
 
-	// (x1,y1) is the first destination
-	int x1 = dest.first.first;
-	int y1 = dest.first.second;
+	tucants_do_move(game, move);
 
-	// (x2,y2) is the second destination
-	int x2 = dest.second.first;
-	int y2 = dest.second.second;
+	if (num_food_cells != 0){
+		tucants_set_chance_node(game, true, num_food_cells);
+		game.move = move;
+		tucants_check_hash(game);
+	}
+}
 
-	// Cases for the first destination
-	if (is_inside_board(x1, y1) && !of_same_color(pos, i, j, x1, y1)){
-		// (x1,y1) can be either empty or have an opponent ant
+// The outcomes of a chance node are how much food is obtained
+typedef int tucants_outcome;
+
+// Writes to out the outcomes of the chance node game along with their probabilities. Returns their number.
+template<class OutputIterator>
+int tucants_outcomes(const tucants_game& game, OutputIterator out){
+	/**
+	 * First of all let us notice that we can have at most 2 food cells in a move (because food appears
+	 * in the middle cells only).
+	 * The food has already been consumed from the board by the move, so the number of food cells
+	 * was counted when the chance node was created.
+	 * See the report for what we do in each case.
+	 */
+	switch(game.food_cells){
+	case 1:
+		// the first one with probability 1/3 obtains the food
+		*out++ = std::make_pair(tucants_outcome(1), static_cast<double>(1.0/3.0));
+		// the second one with probability 2/3 destroys the food
+		*out++ = std::make_pair(tucants_outcome(0), static_cast<double>(2.0/3.0));
+		return 2;
+	case 2:
+		// the first one with probability 4/9 obtains no food
+		*out++ = std::make_pair(tucants_outcome(0), static_cast<double>(4.0/9.0));
+		// the second one with probability 4/9 obtains one food
+		*out++ = std::make_pair(tucants_outcome(1), static_cast<double>(4.0/9.0));
+		// the third one with probability 1/9 obtains 2 food
+		*out++ = std::make_pair(tucants_outcome(2), static_cast<double>(1.0/9.0));
+		return 3;
+	default:
+		assert(0 && "tucants_outcomes(): chance node invalid food cells count");
+		return 0;
+	}
+}
 
-		// if it is empty then we store this move only if the other move from (x2,y2) doesn't have
-		// captivity precedence
-		if (!has_ant(pos, x1, y1)){
-			if (is_inside_board(x2, y2) && !of_same_color(pos, i, j, x2, y2) && has_ant(pos,x2,y2)){
-				// do nothing if move cannot be made
-				std::pair<int,int> next = make_move_in_same_direction(i, j, x2, y2, color);
+// Resolves the chance node game with the given outcome: the food obtained is scored by the player who made the
+// move of the chance node (as doMove() does when it draws it) and none of the children is a chance node.
+// What is needed to undo it is saved at undo. The player is the one who hasn't the turn: game.move can't tell,
+// since the moves of the subtrees searched under the outcomes before this one overwrite it (and their undo
+// doesn't restore it).
+inline void tucants_apply_outcome(tucants_game& game, tucants_outcome outcome, tucants_undo& undo){
+	Move null_move;
 
-				int next_x = next.first;
-				int next_y = next.second;
+	null_move.tile[0][0] = -1;
 
+	tucants_save(game, null_move, undo);
 
-				if (has_ant(pos, next_x,next_y)){
-					Move move;
+	tucants_set_chance_node(game, false);
+	tucants_set_food_obtained(game, outcome);
+	tucants_add_score(game, 1 - game.pos.turn, outcome);
+	tucants_check_hash(game);
+}
 
-					move.color = color;
+// Undoes the move or outcome saved at undo
+inline void tucants_undo_move(tucants_game& game, const tucants_undo& undo){
+	const Move& move = undo.move;
 
-					move.tile[0][0] = i;
-					move.tile[1][0] = j;
-					move.tile[0][1] = x1;
-					move.tile[1][1] = y1;
-					move.tile[0][2] = -1;
+	if (move.tile[0][0] != -1){
+		char color = move.color;
 
-					moves.push_back(move);
-				}
-			}
-			else{
-				Move move;
+		game.pos.board[move.tile[0][0]][move.tile[1][0]] = color;
 
-				move.color = color;
+		for (int i = 1; i < MAXIMUM_MOVE_SIZE && move.tile[0][i] != -1; ++i){
+			int x = move.tile[0][i];
+			int y = move.tile[1][i];
 
-				move.tile[0][0] = i;
-				move.tile[1][0] = j;
-				move.tile[0][1] = x1;
-				move.tile[1][1] = y1;
-				move.tile[0][2] = -1;
+			game.pos.board[x][y] = (undo.bb.food & (1ULL << bitboard_index(x, y))) ? RTILE : EMPTY;
 
-				moves.push_back(move);
+			if (abs(x - move.tile[0][i - 1]) == 2){
+				game.pos.board[(x + move.tile[0][i - 1])/2][(y + move.tile[1][i - 1])/2] = 1 - color;
 			}
 		}
-		else{
-			// else there is an opponent ant there
-			std::list<Move> capt_moves = which_moves_captivity_case(pos, i, j, x1, y1, color);
-
-			moves.insert(moves.begin(), capt_moves.begin(), capt_moves.end());
-		}
 	}
 
-	// Cases for the second destination
-	if (is_inside_board(x2, y2) && !of_same_color(pos, i, j, x2, y2)){
-		// (x2,y2) can be either empty or have an opponent ant
-
-		// if it is empty then we store this move only if the other move from (x2,y2) doesn't have
-		// captivity precedence
-		if (!has_ant(pos, x2, y2)){
-			if (is_inside_board(x1, y1) && !of_same_color(pos, i, j, x1, y1) && has_ant(pos,x1,y1)){
-				// do nothing if move cannot be made
-				std::pair<int,int> next = make_move_in_same_direction(i, j, x1, y1, color);
-
-				int next_x = next.first;
-				int next_y = next.second;
-
-				// if the cell at (next_x,next_y) isn't empty then we do nothing
-				if (has_ant(pos, next_x,next_y)){
-					Move move;
-
-					move.color = color;
-
-					move.tile[0][0] = i;
-					move.tile[1][0] = j;
-					move.tile[0][1] = x2;
-					move.tile[1][1] = y2;
-					move.tile[0][2] = -1;
-
-					moves.push_back(move);
-				}
-			}
-			else{
-				Move move;
+	game.bb = undo.bb;
+	game.terms = undo.terms;
+	game.key = undo.key;
+	game.pos.score[WHITE] = undo.score[WHITE];
+	game.pos.score[BLACK] = undo.score[BLACK];
+	game.pos.turn = undo.turn;
+	game.is_chance_node = undo.is_chance_node;
+	game.food_obtained = undo.food_obtained;
+	game.food_cells = undo.food_cells;
+
+	tucants_check_hash(game);
+}
 
-				move.color = color;
+// Writes to out the moves of the player who has turn at the game (captivity moves have precedence).
+// A player that can't move has the null move which just passes the turn. Returns the number of moves.
+template<class OutputIterator>
+int tucants_moves(const tucants_game& game, OutputIterator out){
+	int count = bitboard_moves(game.bb, game.pos.turn, out);
 
-				move.tile[0][0] = i;
-				move.tile[1][0] = j;
-				move.tile[0][1] = x2;
-				move.tile[1][1] = y2;
-				move.tile[0][2] = -1;
+	if (count == 0){
+		Move null_move;
 
-				moves.push_back(move);
-			}
-		}
-		else{
-			// else there is an opponent ant there
-			std::list<Move> capt_moves = which_moves_captivity_case(pos, i, j, x2, y2, color);
+		null_move.color = game.pos.turn;
+		null_move.tile[0][0] = -1;
 
-			moves.insert(moves.begin(), capt_moves.begin(), capt_moves.end());
-		}
+		*out++ = null_move;
+		count = 1;
 	}
 
-	return moves;
+	return count;
 }
 
+// The list of successors of a state (for the search on the lists of the successor function). Its nodes are
+// allocated from the arena of the search.
+typedef std::tuple<Move,tucants_game,double> tucants_successor;
+typedef std::list<tucants_successor, search::arena_allocator<tucants_successor> > tucants_successors_list;
+
 // This is a functor object that serves as the successor function object for the
 // minimax algorithm. It works in the following way:
 // It gets as input a Position. That position holds the board as well as who player has turn.
 // For that player that has now turn it returns a list of actions the player can make and the state they
 // lead to.
 struct tucants_successor_function{
-	std::list<std::tuple<Move,tucants_game,double> > operator()(const tucants_game& game) const{
-		char turn = game.pos.turn;
-
-		std::list<std::tuple<Move,tucants_game,double> > all_moves;
+	tucants_successors_list operator()(const tucants_game& game) const{
+		tucants_successors_list all_moves;
+		tucants_undo undo;
 
 		// if we are at a chance node then we have different handling
 		if (game.node_type() == search::StateNodeType::CHANCE_NODE){
-			tucants_game g1 = game;
-			tucants_game g2 = game;
-			tucants_game g3 = game;
-
-			Move move = game.move;
-
-			/**
-			 * First of all let us notice that we can have at most 2 food cells in a move (because food appears
-			 * in the middle cells only).
-			 * So we count the number of food cells first.
-			 * See the report for what we do in each case.
-			 */
-			int num_food_cells = 0;
-			for (int i = 0; i < MAXIMUM_MOVE_SIZE; ++i){
-				if (move.tile[0][i] == -1){
-					break;
-				}
-
-				if (game.pos.board[move.tile[0][i]][move.tile[1][i]] == RTILE){
-					++num_food_cells;
-				}
-			}
-
-			switch(num_food_cells){
-			case 1:
-				// none of them are chance nodes now
-
-				// the first one with probability 1/3 obtains the food
-				g1.is_chance_node = false;
-				g1.food_obtained = 1;
-
-				all_moves.push_back(std::make_tuple(g1.move, g1, static_cast<double>(1.0/3.0)));
-
-				// the second one with probability 2/3 destroys the food
-				g2.is_chance_node = false;
-				g2.food_obtained = 0;
+			search::fixed_vector<std::pair<tucants_outcome,double>, 3> outcomes;
 
-				all_moves.push_back(std::make_tuple(g2.move, g2, static_cast<double>(2.0/3.0)));
-				break;
-			case 2:
-				// none of them are chance nodes now
+			tucants_outcomes(game, std::back_inserter(outcomes));
 
-				// the first one with probability 4/9 obtains no food
-				g1.is_chance_node = false;
-				g1.food_obtained = 0;
+			for (auto it = outcomes.begin(); it != outcomes.end(); ++it){
+				tucants_game new_game = game;
 
-				all_moves.push_back(std::make_tuple(g1.move, g1, static_cast<double>(4.0/9.0)));
+				tucants_apply_outcome(new_game, it->first, undo);
 
-				// the second one with probability 4/9 obtains one food
-				g2.is_chance_node = false;
-				g2.food_obtained = 1;
-
-				all_moves.push_back(std::make_tuple(g2.move, g2, static_cast<double>(4.0/9.0)));
-
-				// the third one with probability 1/9 obtains 2 food
-				g3.is_chance_node = false;
-				g3.food_obtained = 2;
-
-				all_moves.push_back(std::make_tuple(g3.move, g3, static_cast<double>(1.0/9.0)));
-				break;
-			default:
-				assert(0 && "tucants_successor_function: chance node invalid food cells count");
-				break;
+				all_moves.push_back(std::make_tuple(game.move, new_game, it->second));
 			}
 
 			return all_moves;
 		}
 
-		// we are not a chance node
-		for (int i = 0; i < BOARD_ROWS; ++i){
-			for (int j = 0; j < BOARD_COLUMNS; ++j){
-				// for each of the ants in board for the player who has turn
-				if (game.pos.board[i][j] == turn){
-					// for that ant of the player get all the moves it can make
-					std::list<Move> moves = std::move(which_moves(game.pos,i,j));
+		// we are not a chance node. The bitboard move generator gives only the captivity moves if there are any.
+		tucants_move_list moves;
 
-					// record each move as well as the state they lead to
-					for (auto it = moves.begin(); it != moves.end(); ++it){
-						// the new state for the current move
-						tucants_game new_game = game;
+		tucants_moves(game, std::back_inserter(moves));
 
-						new_game.is_chance_node = false;
-						new_game.food_obtained = 0;
+		for (auto it = moves.begin(); it != moves.end(); ++it){
+			// the new state for the current move
+			tucants_game new_game = game;
 
-						// we must now apply the move to that new state
-						doMove(&new_game.pos, &(*it));
+			// we must now apply the move to that new state
+			tucants_apply(new_game, *it, undo);
 
-						all_moves.push_back(std::make_tuple(*it, new_game, static_cast<double>(0.0)));
-					}
-				}
-			}
+			all_moves.push_back(std::make_tuple(*it, new_game, static_cast<double>(0.0)));
 		}
 
-		// here we look out for chance nodes. More specifically if we land to a cell with food we baptize
-		// that node a chance node
-		std::for_each(all_moves.begin(), all_moves.end(), [](std::tuple<Move,tucants_game,double>& elem){
-			Move& move = std::get<0>(elem);
-			tucants_game& game = std::get<1>(elem);
-
-			// just search if we have a cell with food there
-			for (int i = 0; i < MAXIMUM_MOVE_SIZE; ++i){
-				if (move.tile[0][i] == -1){
-					break;
-				}
-
-				if (game.pos.board[move.tile[0][i]][move.tile[1][i]] == RTILE){
-					game.is_chance_node = true;
-					game.food_obtained = 0;
-					game.move = move;
-					break;
-				}
-			}
-		});
-
-		// if we have moves that have captivity precedence then we must filter out the normal moves
-		std::list<std::tuple<Move,tucants_game,double> > captivity_moves;
-
-		std::copy_if(all_moves.begin(), all_moves.end(), std::back_inserter(captivity_moves), [](const std::tuple<Move,tucants_game,double>& elem) -> bool{
-			// must check here whether the move is a captivity move
-			Move move = std::get<0>(elem);
-
-			return num_captured_ants(move) != 0;
-		});
-
-		if (!captivity_moves.empty()){
-			return captivity_moves;
-		}
-		else{
-			return all_moves;
-		}
+		return all_moves;
 	}
 };
 
@@ -677,13 +1002,14 @@ struct tucants_successor_function{
 struct tucants_game_cutoff{
 	// return true if we must cutoff
 	bool operator()(const tucants_game& game) const{
-		// cutoff when the game has ended
-		return ants_all_removed(game.pos);
+		// cutoff when the game has ended (when all the ants have been removed from the board)
+		return game.terms.ants[WHITE] + game.terms.ants[BLACK] == 0;
 	}
 };
 
-// return the utility of the board from the player's side given
-inline int player_utility(const tucants_game& game, char player){
+// return the utility of the board from the player's side given, computed from the board alone. This is the
+// reference that the evaluation with the incremental terms (see player_utility()) must agree with.
+inline int full_player_utility(const tucants_game& game, char player){
 	int value = 0;
 
 	for (int i = 0; i < BOARD_ROWS; ++i){
@@ -693,7 +1019,8 @@ inline int player_utility(const tucants_game& game, char player){
 				value += board_utilities[player][i][j];
 
 				// give additional value if it can make moves and captivity moves
-				std::list<Move> moves = std::move(which_moves(game.pos,i,j));
+				tucants_move_list moves;
+				which_moves(game.pos, i, j, std::back_inserter(moves));
 
 				int captivity_moves = 0;
 				for (auto it = moves.begin(); it != moves.end(); ++it){
@@ -721,44 +1048,63 @@ inline int player_utility(const tucants_game& game, char player){
 		}
 	}
 
-	// but now loose utility if the opponent can capture an ant from me
-	char opponent = 1 - player;
-
-	tucants_successor_function succ;
-	tucants_game game2 = game;
-	game2.pos.turn = opponent;
+	// the captures pending at the position are not looked at: the search only evaluates the positions where
+	// the player who has turn can't capture (see tucants::quiet())
 
-	std::list<std::tuple<Move,tucants_game,double> > moves = succ(game2);
+	// the food obtained is already in the score (see tucants_apply_outcome())
 
-	// count from those moves how many ants it can capture
-	int num_captures = 0;
-	for (auto it = moves.begin(); it != moves.end(); ++it){
-		num_captures += num_captured_ants(std::get<0>(*it));
-	}
+	return value;
+}
 
-	value -= (2*num_captures);
+// Returns the mobility term of the utility of the player: the moves of each of its ants and the ants they capture
+// (see bitboard_mobility())
+inline int player_mobility(const tucants_game& game, char player){
+	return bitboard_mobility(game.bb, player);
+}
 
-	// also give more value if at that state we have a food captured
-	value += 2*(game.pos.turn == player ? game.food_obtained : 0);
+// Returns the part of the utility of the player that is kept with the state: the positional and the protection
+// terms (all but the mobility)
+inline int kept_player_utility(const tucants_game& game, char player){
+	return game.terms.positional[static_cast<int>(player)] + game.terms.protection[static_cast<int>(player)];
+}
 
-	return value;
+// return the utility of the board from the player's side given: the positional and the protection terms are kept
+// with the state, only the mobility is worked out here (on the bitboards). Compiled with _FULL_EVALUATION_ the
+// utility is computed from scratch instead (see full_player_utility()).
+inline int player_utility(const tucants_game& game, char player){
+#ifdef _FULL_EVALUATION_
+	return full_player_utility(game, player);
+#else
+	return kept_player_utility(game, player) + player_mobility(game, player);
+#endif
 }
 
+// The bound of the absolute value of the evaluation function. The evaluations of real positions stay well within
+// +-100 (a dozen ants with their positional, mobility and protection values, plus the score), the bound leaves
+// plenty of room and the evaluation is clamped to it so that the search can rely on it (see tucants::bounded()).
+static const int tucants_utility_bound = 1000;
+
+// The margins of the mobility part of the evaluation (the mobility of the player less that of the opponent) below
+// and above which the lazy evaluation takes the value of a leaf to be (see tucants::evaluation_bounds()). They are
+// the 0.1% and the 99.9% quantiles over the leaves of searches to depth 6 of 200 positions of random games
+// (calibrated with test.cpp), so about one leaf in 500 falls outside them.
+static const int tucants_mobility_margins[2] = {-9, 8};
+
 // this is the evaluation function for the tucants game
 struct tucants_evaluation_function{
 	int operator()(const tucants_game& game) const{
-		return (player_utility(game, game.player) + game.pos.score[game.player]) - (player_utility(game, 1 - game.player) + game.pos.score[1 - game.player]);
+		int value = (player_utility(game, game.player) + game.pos.score[game.player]) - (player_utility(game, 1 - game.player) + game.pos.score[1 - game.player]);
+
+		return std::max(-tucants_utility_bound, std::min(tucants_utility_bound, value));
 	}
 };
 
-// this is the action ordering for the tucants game.
+// this is the action ordering for the tucants game: the longer capture chains first. The evaluation function is
+// left for the leaves, the search orders the rest with its heuristics (see tucants::action_priority()).
 struct tucants_action_ordering{
-	void operator()(std::list<std::tuple<Move,tucants_game,double> >& successors) const{
-		tucants_evaluation_function eval;
-		// sort in ascending order by evaluation function
-		successors.sort([&](const std::tuple<Move,tucants_game,double>& a, const std::tuple<Move,tucants_game,double>& b) -> bool{
-			// return true if a is less than b by the evaluation function
-			return eval(std::get<1>(a)) < eval(std::get<1>(b));
+	void operator()(tucants_successors_list& successors) const{
+		successors.sort([](const tucants_successor& a, const tucants_successor& b) -> bool{
+			return num_captured_ants(std::get<0>(a)) > num_captured_ants(std::get<0>(b));
 		});
 	}
 };
@@ -772,6 +1118,14 @@ struct tucants{
 	typedef tucants_evaluation_function evaluation_function_type;
 	typedef tucants_game_cutoff cutoff_test_type;
 	typedef tucants_action_ordering action_ordering_type;
+	typedef tucants_successors_list successors_list_type;
+
+	// the search applies and undoes the moves on a single state
+	typedef search::make_unmake_mode search_mode_type;
+	typedef tucants_undo undo_type;
+	typedef tucants_move_list action_list_type;
+	typedef tucants_outcome outcome_type;
+	typedef search::fixed_vector<std::pair<tucants_outcome,double>, 3> outcome_list_type;
 
 	// Returns the minus infinity for the range of values representable by the utility type
 	static utility_type min_utility_value(){
@@ -811,8 +1165,104 @@ struct tucants{
 	// then the next two values in the tuple are the lowest value achievable and the highest value achievable
 	// respectively. This is used to apply alpha-beta pruning for the chance nodes.
 	static std::tuple<bool, utility_type, utility_type> bounded(){
-		return std::make_tuple(false,0,0);
+		return std::make_tuple(true, -tucants_utility_bound, tucants_utility_bound);
+	}
+
+	// Returns the Zobrist hash key of the state
+	static std::uint64_t hash(const state_type& state){
+		return state.key;
+	}
+
+	// Computes the hash key of the root state of a search
+	static void prepare(state_type& state){
+		tucants_rehash(state);
+	}
+
+	// A position is quiet if the player who has turn can't capture. Otherwise capturing is mandatory, so the
+	// search goes on through the capture chains (each of which takes an ant off the board) until it is quiet.
+	static bool quiet(const state_type& state){
+		return bitboard_capturers(state.bb, state.pos.turn) == 0;
+	}
+
+	// The moves of the player who has turn are generated in two stages: the captures and then (if there are
+	// none, since capturing is mandatory) the simple moves, or the null move if there are no moves at all
+	static const int num_action_stages = 2;
+
+	static void actions(const state_type& state, int stage, action_list_type& actions){
+		if (stage == 0){
+			bitboard_capture_moves(state.bb, state.pos.turn, std::back_inserter(actions));
+		}
+		else if (bitboard_capturers(state.bb, state.pos.turn) == 0){
+			tucants_moves(state, std::back_inserter(actions));
+		}
 	}
+
+	// Whether the move is a move of the player who has turn (the null move only if there are no others)
+	static bool legal(const state_type& state, const action_type& action){
+		if (action.tile[0][0] == -1){
+			return action.color == state.pos.turn && !bitboard_has_moves(state.bb, state.pos.turn);
+		}
+		return bitboard_is_move(state.bb, state.pos.turn, action);
+	}
+
+	// The evaluation of a state is bounded by the terms kept with the state and the margins of the mobility
+	static void evaluation_bounds(const state_type& state, utility_type& lower, utility_type& upper){
+		char player = state.player;
+		int value = (kept_player_utility(state, player) + state.pos.score[static_cast<int>(player)]) - (kept_player_utility(state, 1 - player) + state.pos.score[1 - player]);
+
+		lower = std::max(-tucants_utility_bound, std::min(tucants_utility_bound, value + tucants_mobility_margins[0]));
+		upper = std::max(-tucants_utility_bound, std::min(tucants_utility_bound, value + tucants_mobility_margins[1]));
+	}
+
+	// The captures go first, the longer chains before the shorter ones (all the moves of a player who can
+	// capture are captures, but the chains differ)
+	static int action_priority(const action_type& action){
+		return num_captured_ants(action);
+	}
+
+	// The moves are told apart in the history of the search by their color and their first and last cells
+	static const std::size_t num_history_keys = 2*BOARD_ROWS*BOARD_COLUMNS*BOARD_ROWS*BOARD_COLUMNS;
+
+	static std::size_t history_key(const action_type& action){
+		if (action.tile[0][0] == -1){
+			return 0;
+		}
+
+		int last = 1;
+
+		while (last < MAXIMUM_MOVE_SIZE && action.tile[0][last] != -1){
+			++last;
+		}
+		--last;
+
+		std::size_t from = action.tile[0][0]*BOARD_COLUMNS + action.tile[1][0];
+		std::size_t to = action.tile[0][last]*BOARD_COLUMNS + action.tile[1][last];
+
+		return (static_cast<std::size_t>(action.color)*BOARD_ROWS*BOARD_COLUMNS + from)*BOARD_ROWS*BOARD_COLUMNS + to;
+	}
+
+	// The outcomes of a chance node
+	static void outcomes(const state_type& state, outcome_list_type& outcomes){
+		tucants_outcomes(state, std::back_inserter(outcomes));
+	}
+
+	static void apply(state_type& state, const action_type& action, undo_type& undo){
+		tucants_apply(state, action, undo);
+	}
+
+	static void apply_outcome(state_type& state, const outcome_type& outcome, undo_type& undo){
+		tucants_apply_outcome(state, outcome, undo);
+	}
+
+	static void undo(state_type& state, const undo_type& undo){
+		tucants_undo_move(state, undo);
+	}
+};
+
+// The game traits for searching the tucants game on the lists of the successor function, with a copy of the
+// game for each child (kept as a fallback of the search with make and undo).
+struct tucants_list : tucants{
+	typedef search::successor_list_mode search_mode_type;
 };
 
 #endif /* TUCANTS_GAME_HPP_ */
@@ -0,0 +1,173 @@
+/*
+ * work_stealing_pool.hpp
+ *
+ *  Created on: May 30, 2013
+ *      Author: croatoan
+ */
+
+#ifndef WORK_STEALING_POOL_HPP_
+#define WORK_STEALING_POOL_HPP_
+
+#include<atomic>
+#include<condition_variable>
+#include<cstddef>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+namespace search{
+
+/**
+ * A pool of threads that share their work by stealing it. Every thread has a queue of tasks of its own: it
+ * pushes to and pops from the back of it, while the other threads steal from its front (the oldest tasks, which
+ * are usually the biggest ones). Queue 0 belongs to the thread that owns the pool, which is not one of the threads
+ * of the pool: it pushes the tasks and runs them itself as it sees fit. Each of the other threads steals a task
+ * whenever it is idle and runs it with the function given at the construction.
+ *
+ * The threads of the pool only look for work while the pool is active (see activate()) and sleep otherwise.
+ *
+ * Task : the type of the tasks, copied in and out of the queues
+ */
+template<class Task>
+class work_stealing_pool{
+public:
+	// run(i, task) is called by the i-th thread of the pool (starting from 1) to run a task it stole
+	work_stealing_pool(std::size_t threads, const std::function<void(std::size_t, Task&)>& _run) : run(_run), quit(false), active(false){
+		for (std::size_t i = 0; i < threads; ++i){
+			queues.push_back(std::unique_ptr<queue>(new queue));
+		}
+
+		for (std::size_t i = 1; i < threads; ++i){
+			workers.push_back(std::thread([this, i](){
+				work(i);
+			}));
+		}
+	}
+
+	work_stealing_pool(const work_stealing_pool&) = delete;
+	work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+	~work_stealing_pool(){
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			quit = true;
+		}
+		idle.notify_all();
+
+		for (std::size_t i = 0; i < workers.size(); ++i){
+			workers[i].join();
+		}
+	}
+
+	// the number of queues (the threads of the pool and the owner)
+	std::size_t size() const{
+		return queues.size();
+	}
+
+	// Lets the threads of the pool look for work (until deactivate() is called)
+	void activate(){
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex);
+			active = true;
+		}
+		idle.notify_all();
+	}
+
+	void deactivate(){
+		std::lock_guard<std::mutex> lock(idle_mutex);
+		active = false;
+	}
+
+	// Pushes a task to the back of the given queue
+	void push(std::size_t i, const Task& task){
+		std::lock_guard<std::mutex> lock(queues[i]->mutex);
+		queues[i]->tasks.push_back(task);
+	}
+
+	// Pops the task at the back of the given queue if there is one and it satisfies the predicate
+	template<class Predicate>
+	bool pop(std::size_t i, Task& task, Predicate predicate){
+		std::lock_guard<std::mutex> lock(queues[i]->mutex);
+		std::deque<Task>& tasks = queues[i]->tasks;
+
+		if (tasks.empty() || !predicate(tasks.back())){
+			return false;
+		}
+
+		task = tasks.back();
+		tasks.pop_back();
+		return true;
+	}
+
+	// Steals the task at the front of any queue other than the thief's own. Returns false if all are empty.
+	bool steal(std::size_t thief, Task& task){
+		return steal(thief, task, [](const Task&){
+			return true;
+		});
+	}
+
+	// Steals the task at the front of any queue other than the thief's own if it satisfies the predicate
+	template<class Predicate>
+	bool steal(std::size_t thief, Task& task, Predicate predicate){
+		for (std::size_t k = 1; k < queues.size(); ++k){
+			queue& victim = *queues[(thief + k)%queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+
+			if (!victim.tasks.empty() && predicate(victim.tasks.front())){
+				task = victim.tasks.front();
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+private:
+	struct queue{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	// the loop of the i-th thread of the pool
+	void work(std::size_t i){
+		Task task;
+
+		for (;;){
+			// sleep while the pool is not active (the flags are only changed with the mutex held so that no
+			// wake up is missed)
+			if (!active.load(std::memory_order_relaxed) || quit.load(std::memory_order_relaxed)){
+				std::unique_lock<std::mutex> lock(idle_mutex);
+				idle.wait(lock, [this](){
+					return quit.load() || active.load();
+				});
+
+				if (quit){
+					return;
+				}
+			}
+
+			if (steal(i, task)){
+				run(i, task);
+			}
+			else{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	std::function<void(std::size_t, Task&)> run;
+	std::vector<std::unique_ptr<queue> > queues;
+	std::vector<std::thread> workers;
+
+	std::mutex idle_mutex;
+	std::condition_variable idle;
+	std::atomic<bool> quit;
+	std::atomic<bool> active;
+};
+
+} // namespace search
+
+#endif /* WORK_STEALING_POOL_HPP_ */